@@ -0,0 +1,222 @@
+/*
+ * Copyright Peter G. Jensen
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * File:   alloc.cpp
+ * Author: Peter G. Jensen
+ *
+ * Created on October 17, 2026, 8:15 PM
+ */
+
+#include "alloc.h"
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+namespace prlearn {
+    namespace bench {
+
+        namespace {
+            std::atomic<bool> tracking{false};
+            std::atomic<uint64_t> n_allocations{0}, n_deallocations{0}, n_bytes{0};
+            std::atomic<int64_t> live{0}, peak{0};
+
+            // every block is preceded by its size, with the lowest bit set
+            // when it was tracked; keeps the alignment of malloc.
+            constexpr size_t header = alignof (std::max_align_t);
+
+            // true when the allocation is tracked
+            bool count(size_t size) {
+                if (!tracking.load(std::memory_order_relaxed))
+                    return false;
+                n_allocations.fetch_add(1, std::memory_order_relaxed);
+                n_bytes.fetch_add(size, std::memory_order_relaxed);
+                auto now = live.fetch_add(size, std::memory_order_relaxed) + (int64_t) size;
+                auto p = peak.load(std::memory_order_relaxed);
+                while (now > p && !peak.compare_exchange_weak(p, now, std::memory_order_relaxed)) {
+                }
+                return true;
+            }
+
+            void uncount(size_t tag) {
+                if ((tag & 1) != 0) {
+                    n_deallocations.fetch_add(1, std::memory_order_relaxed);
+                    live.fetch_sub(tag >> 1, std::memory_order_relaxed);
+                }
+            }
+
+            void* allocate(size_t size) {
+                if (size == 0) size = 1;
+                auto raw = static_cast<char*> (std::malloc(size + header));
+                if (raw == nullptr)
+                    return nullptr;
+                *reinterpret_cast<size_t*> (raw) = (size << 1) | (count(size) ? 1 : 0);
+                return raw + header;
+            }
+
+            void deallocate(void* ptr) {
+                if (ptr == nullptr)
+                    return;
+                auto raw = static_cast<char*> (ptr) - header;
+                uncount(*reinterpret_cast<size_t*> (raw));
+                std::free(raw);
+            }
+
+            // the std::align_val_t forms, as used by std::pmr::new_delete_resource;
+            // beyond the alignment of malloc, the tag is just before the block
+            // and the offset to the start of the allocation before that.
+            void* allocate(size_t size, std::align_val_t alignment) {
+                if ((size_t) alignment <= header)
+                    return allocate(size);
+                if (size == 0) size = 1;
+                const size_t align = (size_t) alignment;
+                const size_t total = ((size + align + align - 1) / align) * align;
+                auto raw = static_cast<char*> (std::aligned_alloc(align, total));
+                if (raw == nullptr)
+                    return nullptr;
+                auto tag = reinterpret_cast<size_t*> (raw + align);
+                tag[-1] = (size << 1) | (count(size) ? 1 : 0);
+                tag[-2] = align;
+                return raw + align;
+            }
+
+            void deallocate(void* ptr, std::align_val_t alignment) {
+                if ((size_t) alignment <= header)
+                    return deallocate(ptr);
+                if (ptr == nullptr)
+                    return;
+                auto tag = static_cast<size_t*> (ptr);
+                uncount(tag[-1]);
+                std::free(static_cast<char*> (ptr) - tag[-2]);
+            }
+        }
+
+        void track_allocations(bool enable) {
+            tracking.store(enable);
+        }
+
+        void reset_allocations() {
+            n_allocations = 0;
+            n_deallocations = 0;
+            n_bytes = 0;
+            live = 0;
+            peak = 0;
+        }
+
+        alloc_stats_t allocations() {
+            alloc_stats_t res;
+            res._allocations = n_allocations;
+            res._deallocations = n_deallocations;
+            res._bytes = n_bytes;
+            res._live = live;
+            res._peak = peak;
+            return res;
+        }
+    }
+}
+
+// The replacements; the array and nothrow forms would forward to these
+// by default, but are replaced as well to not depend on that.
+
+void* operator new(size_t size) {
+    auto p = prlearn::bench::allocate(size);
+    if (p == nullptr) throw std::bad_alloc();
+    return p;
+}
+
+void* operator new[](size_t size) {
+    auto p = prlearn::bench::allocate(size);
+    if (p == nullptr) throw std::bad_alloc();
+    return p;
+}
+
+void* operator new(size_t size, const std::nothrow_t&) noexcept {
+    return prlearn::bench::allocate(size);
+}
+
+void* operator new[](size_t size, const std::nothrow_t&) noexcept {
+    return prlearn::bench::allocate(size);
+}
+
+void operator delete(void* ptr) noexcept {
+    prlearn::bench::deallocate(ptr);
+}
+
+void operator delete[](void* ptr) noexcept {
+    prlearn::bench::deallocate(ptr);
+}
+
+void operator delete(void* ptr, size_t) noexcept {
+    prlearn::bench::deallocate(ptr);
+}
+
+void operator delete[](void* ptr, size_t) noexcept {
+    prlearn::bench::deallocate(ptr);
+}
+
+void operator delete(void* ptr, const std::nothrow_t&) noexcept {
+    prlearn::bench::deallocate(ptr);
+}
+
+void operator delete[](void* ptr, const std::nothrow_t&) noexcept {
+    prlearn::bench::deallocate(ptr);
+}
+
+void* operator new(size_t size, std::align_val_t alignment) {
+    auto p = prlearn::bench::allocate(size, alignment);
+    if (p == nullptr) throw std::bad_alloc();
+    return p;
+}
+
+void* operator new[](size_t size, std::align_val_t alignment) {
+    auto p = prlearn::bench::allocate(size, alignment);
+    if (p == nullptr) throw std::bad_alloc();
+    return p;
+}
+
+void* operator new(size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept {
+    return prlearn::bench::allocate(size, alignment);
+}
+
+void* operator new[](size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept {
+    return prlearn::bench::allocate(size, alignment);
+}
+
+void operator delete(void* ptr, std::align_val_t alignment) noexcept {
+    prlearn::bench::deallocate(ptr, alignment);
+}
+
+void operator delete[](void* ptr, std::align_val_t alignment) noexcept {
+    prlearn::bench::deallocate(ptr, alignment);
+}
+
+void operator delete(void* ptr, size_t, std::align_val_t alignment) noexcept {
+    prlearn::bench::deallocate(ptr, alignment);
+}
+
+void operator delete[](void* ptr, size_t, std::align_val_t alignment) noexcept {
+    prlearn::bench::deallocate(ptr, alignment);
+}
+
+void operator delete(void* ptr, std::align_val_t alignment, const std::nothrow_t&) noexcept {
+    prlearn::bench::deallocate(ptr, alignment);
+}
+
+void operator delete[](void* ptr, std::align_val_t alignment, const std::nothrow_t&) noexcept {
+    prlearn::bench::deallocate(ptr, alignment);
+}
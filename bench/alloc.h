@@ -0,0 +1,51 @@
+/*
+ * Copyright Peter G. Jensen
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * File:   alloc.h
+ * Author: Peter G. Jensen
+ *
+ * Created on October 17, 2026, 8:15 PM
+ */
+
+#ifndef BENCH_ALLOC_H
+#define BENCH_ALLOC_H
+
+#include <cstddef>
+#include <cstdint>
+
+namespace prlearn {
+    namespace bench {
+
+        // Counters of the global operator new/delete, which are replaced in
+        // the benchmark executable. Only allocations made while tracking
+        // is on are counted, and only their deallocations reduce _live.
+        struct alloc_stats_t {
+            uint64_t _allocations = 0;
+            uint64_t _deallocations = 0;
+            uint64_t _bytes = 0;
+            int64_t _live = 0;
+            int64_t _peak = 0;
+        };
+
+        void track_allocations(bool enable);
+        void reset_allocations();
+        alloc_stats_t allocations();
+    }
+}
+
+#endif /* BENCH_ALLOC_H */
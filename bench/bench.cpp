@@ -0,0 +1,362 @@
+/*
+ * Copyright Peter G. Jensen
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * File:   bench.cpp
+ * Author: Peter G. Jensen
+ *
+ * Created on October 17, 2026, 6:10 PM
+ */
+
+#include "bench.h"
+#include "alloc.h"
+
+#include "MLearning.h"
+#include "SimpleMLearning.h"
+#include "QLearning.h"
+#include "RefinementTree.h"
+#include "SimpleRegressor.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <cmath>
+#include <memory_resource>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <sys/resource.h>
+#endif
+
+namespace prlearn {
+    namespace bench {
+
+        using steady = std::chrono::steady_clock;
+
+        static size_t proc_status(const char* key) {
+            std::ifstream in("/proc/self/status");
+            std::string line;
+            const size_t len = strlen(key);
+            while (std::getline(in, line)) {
+                if (line.compare(0, len, key) == 0)
+                    return std::strtoull(line.c_str() + len + 1, nullptr, 10);
+            }
+            return 0;
+        }
+
+        size_t current_rss() {
+            return proc_status("VmRSS");
+        }
+
+        size_t peak_rss() {
+            auto peak = proc_status("VmHWM");
+#if defined(__unix__) || defined(__APPLE__)
+            if (peak == 0) {
+                rusage usage;
+                getrusage(RUSAGE_SELF, &usage);
+#if defined(__APPLE__)
+                peak = usage.ru_maxrss / 1024;
+#else
+                peak = usage.ru_maxrss;
+#endif
+            }
+#endif
+            return peak;
+        }
+
+        void reset_peak_rss() {
+            // Linux only; resets VmHWM to the current rss
+            std::ofstream out("/proc/self/clear_refs");
+            out << "5";
+        }
+
+        static double percentile(std::vector<double>& sorted, double p) {
+            if (sorted.empty()) return 0;
+            auto i = (size_t) std::ceil(p * sorted.size());
+            return sorted[std::min(sorted.size() - 1, i == 0 ? 0 : i - 1)];
+        }
+
+        static std::unique_ptr<std::pmr::memory_resource> make_resource(const std::string& memory) {
+            if (memory == "pool")
+                return std::make_unique<std::pmr::unsynchronized_pool_resource>();
+            if (memory == "monotonic")
+                return std::make_unique<std::pmr::monotonic_buffer_resource>();
+            return nullptr;
+        }
+
+        template<typename Learner>
+        static bool run(const trace_t& trace, const config_t& config, const std::string& memory, result_t& result) {
+            // the learners break ties with std::rand
+            constexpr unsigned seed = 1;
+            std::srand(seed);
+            reset_peak_rss();
+            const auto base = current_rss();
+            std::vector<size_t> next_labels(trace._n_labels);
+            for (size_t i = 0; i < trace._n_labels; ++i)
+                next_labels[i] = i;
+            std::ofstream record_out;
+            std::unique_ptr<sample_recorder_t> recorder;
+            if (!config._record.empty()) {
+                record_out.open(record_path(config._record, result._learner, trace), std::ios::binary);
+                recorder = std::make_unique<sample_recorder_t>(record_out, config._record_compression, 1 << 16, seed);
+            }
+            {
+                result._tracked = config._allocations;
+                result._timeline.clear();
+                const size_t every = config._timeline > 0 ? std::max<size_t>(1, trace.size() / config._timeline) : 0;
+                if (config._allocations) {
+                    reset_allocations();
+                    track_allocations(true);
+                }
+                // released after the clouds
+                auto resource = make_resource(memory);
+                std::vector<Learner> clouds;
+                {
+                    memory::scope_t scope(resource ? resource.get() : memory::current());
+                    clouds.resize(trace._n_clouds);
+                }
+                auto start = steady::now();
+                size_t samples = 0;
+                result._truncated = false;
+                for (; samples < trace.size(); ++samples) {
+                    if (config._allocations && every > 0 && (samples % every) == 0)
+                        result._timeline.emplace_back(samples, allocations()._live);
+                    auto i = samples;
+                    if (recorder)
+                        recorder->addSample(trace._cloud[i], trace._dimen, trace.from(i), trace.to(i),
+                                next_labels.data(), next_labels.size(), trace._label[i],
+                                trace._dest[i], trace._cost[i], clouds, trace._minimization, 1.0, config._options);
+                    else
+                        clouds[trace._cloud[i]].addSample(trace._dimen, trace.from(i), trace.to(i),
+                                next_labels.data(), next_labels.size(), trace._label[i],
+                                trace._dest[i], trace._cost[i], clouds, trace._minimization, 1.0, config._options);
+                    if ((samples % 256) == 255 &&
+                            std::chrono::duration<double>(steady::now() - start).count() > config._budget) {
+                        ++samples;
+                        result._truncated = samples < trace.size();
+                        break;
+                    }
+                }
+                result._seconds = std::chrono::duration<double>(steady::now() - start).count();
+                if (config._allocations) {
+                    track_allocations(false);
+                    auto stats = allocations();
+                    if (every > 0)
+                        result._timeline.emplace_back(samples, stats._live);
+                    result._allocs_per_sample = samples > 0 ? (double) stats._allocations / samples : 0;
+                    result._bytes_per_sample = samples > 0 ? (double) stats._bytes / samples : 0;
+                    result._peak_live = stats._peak;
+                    result._live = stats._live;
+                }
+                result._samples = samples;
+                result._samples_per_sec = result._seconds > 0 ? samples / result._seconds : 0;
+
+                std::vector<double> latency;
+                latency.reserve(config._lookups);
+                double sink = 0;
+                for (size_t j = 0; j < config._lookups && samples > 0; ++j) {
+                    auto i = (j * 7919) % samples;
+                    auto& cloud = clouds[trace._cloud[i]];
+                    auto t0 = steady::now();
+                    auto q = cloud.lookup(trace._label[i], trace.from(i), trace._dimen);
+                    auto t1 = steady::now();
+                    sink += q.avg();
+                    latency.push_back(std::chrono::duration<double, std::nano>(t1 - t0).count());
+                }
+                std::sort(latency.begin(), latency.end());
+                result._lookup_p50 = percentile(latency, 0.5);
+                result._lookup_p90 = percentile(latency, 0.9);
+                result._lookup_p99 = percentile(latency, 0.99);
+                // keep the lookups from being optimized away
+                if (sink == -1) std::abort();
+
+                result._nodes = 0;
+                for (auto& c : clouds)
+                    result._nodes += c.size();
+                auto peak = peak_rss();
+                result._peak_kb = peak > base ? peak - base : 0;
+            }
+            result._workload = trace._name;
+            result._dimen = trace._dimen;
+            result._labels = trace._n_labels;
+            result._clouds = trace._n_clouds - 1;
+            return !recorder || recorder->flush();
+        }
+
+        const std::vector<std::string>& learner_names() {
+            static const std::vector<std::string> names{"QRefinementTree", "QSimpleRegressor", "MLearning", "SimpleMLearning"};
+            return names;
+        }
+
+        const std::vector<std::string>& memory_names() {
+            static const std::vector<std::string> names{"default", "pool", "monotonic"};
+            return names;
+        }
+
+        static bool split_learner(const std::string& learner, std::string& name, std::string& memory) {
+            auto at = learner.find('@');
+            name = learner.substr(0, at);
+            memory = at == std::string::npos ? "default" : learner.substr(at + 1);
+            return std::find(learner_names().begin(), learner_names().end(), name) != learner_names().end() &&
+                    std::find(memory_names().begin(), memory_names().end(), memory) != memory_names().end();
+        }
+
+        bool valid_learner(const std::string& learner) {
+            std::string name, memory;
+            return split_learner(learner, name, memory);
+        }
+
+        bool run(const std::string& learner, const trace_t& trace, const config_t& config, result_t& result) {
+            std::string name, memory;
+            if (!split_learner(learner, name, memory))
+                return false;
+            result._learner = learner;
+            if (name == "QRefinementTree")
+                return run<QLearning < RefinementTree >> (trace, config, memory, result);
+            else if (name == "QSimpleRegressor")
+                return run<QLearning < SimpleRegressor >> (trace, config, memory, result);
+            else if (name == "MLearning")
+                return run<MLearning>(trace, config, memory, result);
+            else
+                return run<SimpleMLearning>(trace, config, memory, result);
+        }
+
+        std::string record_path(const std::string& base, const std::string& learner, const trace_t& trace) {
+            return base + "." + trace._name + "." + learner + ".d" + std::to_string(trace._dimen) +
+                    ".l" + std::to_string(trace._n_labels) + ".c" + std::to_string(trace._n_clouds - 1) +
+                    ".n" + std::to_string(trace.size());
+        }
+
+        report_t::report_t(std::ostream& stream, format_t format, bool allocations)
+        : _stream(stream), _format(format), _allocations(allocations) {
+            switch (_format) {
+                case format_t::TEXT:
+                    _stream << std::left << std::setw(12) << "workload" << std::setw(28) << "learner"
+                            << std::right << std::setw(7) << "dimen" << std::setw(7) << "labels" << std::setw(7) << "clouds"
+                            << std::setw(9) << "samples" << std::setw(12) << "samples/s"
+                            << std::setw(9) << "p50(ns)" << std::setw(9) << "p90(ns)" << std::setw(9) << "p99(ns)"
+                            << std::setw(9) << "nodes" << std::setw(11) << "peak(KiB)";
+                    if (_allocations)
+                        _stream << std::setw(12) << "allocs/smp" << std::setw(12) << "bytes/smp"
+                            << std::setw(13) << "peak-live(B)" << std::setw(13) << "live(B)";
+                    _stream << "\n";
+                    break;
+                case format_t::CSV:
+                    _stream << "workload,learner,dimen,labels,clouds,samples,truncated,seconds,"
+                            "samples_per_sec,lookup_p50_ns,lookup_p90_ns,lookup_p99_ns,nodes,peak_kb,"
+                            "allocs_per_sample,bytes_per_sample,peak_live_bytes,live_bytes,live_timeline\n";
+                    break;
+                case format_t::JSON:
+                    _stream << "[";
+                    break;
+            }
+        }
+
+        report_t::~report_t() {
+            if (_format == format_t::JSON)
+                _stream << (_n > 0 ? "\n]\n" : "]\n");
+            _stream.flush();
+        }
+
+        void report_t::add(const result_t& r) {
+            auto flags = _stream.flags();
+            auto precision = _stream.precision();
+            switch (_format) {
+                case format_t::TEXT:
+                    _stream << std::left << std::setw(12) << r._workload << std::setw(28) << r._learner
+                            << std::right << std::fixed << std::setprecision(0)
+                            << std::setw(7) << r._dimen << std::setw(7) << r._labels << std::setw(7) << r._clouds
+                            << std::setw(9) << r._samples << std::setw(12) << r._samples_per_sec
+                            << std::setw(9) << r._lookup_p50 << std::setw(9) << r._lookup_p90 << std::setw(9) << r._lookup_p99
+                            << std::setw(9) << r._nodes << std::setw(11) << r._peak_kb;
+                    if (_allocations)
+                        _stream << std::setprecision(2) << std::setw(12) << r._allocs_per_sample
+                            << std::setw(12) << r._bytes_per_sample << std::setw(13) << r._peak_live
+                            << std::setw(13) << r._live;
+                    _stream << (r._truncated ? " (truncated)" : "") << "\n";
+                    if (!r._timeline.empty()) {
+                        _stream << "    live bytes at sample:";
+                        for (auto& p : r._timeline)
+                            _stream << " " << p.first << ":" << p.second;
+                        _stream << "\n";
+                    }
+                    break;
+                case format_t::CSV:
+                    _stream << std::setprecision(9) << r._workload << "," << r._learner << ","
+                            << r._dimen << "," << r._labels << "," << r._clouds << ","
+                            << r._samples << "," << (r._truncated ? 1 : 0) << "," << r._seconds << ","
+                            << r._samples_per_sec << "," << r._lookup_p50 << "," << r._lookup_p90 << ","
+                            << r._lookup_p99 << "," << r._nodes << "," << r._peak_kb << ","
+                            << r._allocs_per_sample << "," << r._bytes_per_sample << ","
+                            << r._peak_live << "," << r._live << ",";
+                    for (size_t i = 0; i < r._timeline.size(); ++i)
+                        _stream << (i > 0 ? ";" : "") << r._timeline[i].first << ":" << r._timeline[i].second;
+                    _stream << "\n";
+                    break;
+                case format_t::JSON:
+                    _stream << std::setprecision(9) << (_n > 0 ? ",\n" : "\n")
+                            << "  {\"workload\": \"" << r._workload << "\", \"learner\": \"" << r._learner << "\", "
+                            << "\"dimen\": " << r._dimen << ", \"labels\": " << r._labels << ", \"clouds\": " << r._clouds << ", "
+                            << "\"samples\": " << r._samples << ", \"truncated\": " << (r._truncated ? "true" : "false") << ", "
+                            << "\"seconds\": " << r._seconds << ", \"samples_per_sec\": " << r._samples_per_sec << ", "
+                            << "\"lookup_p50_ns\": " << r._lookup_p50 << ", \"lookup_p90_ns\": " << r._lookup_p90 << ", "
+                            << "\"lookup_p99_ns\": " << r._lookup_p99 << ", \"nodes\": " << r._nodes << ", "
+                            << "\"peak_kb\": " << r._peak_kb;
+                    if (r._tracked) {
+                        _stream << ", \"allocs_per_sample\": " << r._allocs_per_sample
+                                << ", \"bytes_per_sample\": " << r._bytes_per_sample
+                                << ", \"peak_live_bytes\": " << r._peak_live << ", \"live_bytes\": " << r._live
+                                << ", \"live_timeline\": [";
+                        for (size_t i = 0; i < r._timeline.size(); ++i)
+                            _stream << (i > 0 ? ", " : "") << "[" << r._timeline[i].first << ", " << r._timeline[i].second << "]";
+                        _stream << "]";
+                    }
+                    _stream << "}";
+                    break;
+            }
+            ++_n;
+            _stream.flags(flags);
+            _stream.precision(precision);
+            _stream.flush();
+        }
+
+        bool run_matrix(const matrix_t& matrix, const std::vector<std::string>& learners, uint64_t seed,
+                const config_t& config, report_t& report, std::vector<result_t>& results) {
+            for (auto samples : matrix._samples) {
+                for (auto clouds : matrix._clouds) {
+                    for (auto labels : matrix._labels) {
+                        for (auto dimen : matrix._dimens) {
+                            auto trace = sparse_mdp(samples, seed, clouds, labels, 3, dimen);
+                            for (auto& l : learners) {
+                                for (size_t r = 0; r < std::max<size_t>(1, config._repeat); ++r) {
+                                    result_t result;
+                                    if (!run(l, trace, config, result))
+                                        return false;
+                                    report.add(result);
+                                    results.push_back(std::move(result));
+                                }
+                            }
+                        }
+                    }
+                }
+            }
+            return true;
+        }
+    }
+}
@@ -0,0 +1,137 @@
+/*
+ * Copyright Peter G. Jensen
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * File:   bench.h
+ * Author: Peter G. Jensen
+ *
+ * Created on October 17, 2026, 6:10 PM
+ */
+
+#ifndef BENCH_BENCH_H
+#define BENCH_BENCH_H
+
+#include "workloads.h"
+#include "propts.h"
+#include "recorder.h"
+
+#include <string>
+#include <vector>
+#include <ostream>
+#include <limits>
+#include <utility>
+#include <cstdint>
+
+namespace prlearn {
+    namespace bench {
+
+        struct config_t {
+            propts_t _options;
+            size_t _lookups = 10000;
+            // training stops after this many seconds, the result is then
+            // marked as truncated.
+            double _budget = std::numeric_limits<double>::infinity();
+            // count the heap-traffic of the training, see alloc.h; also
+            // samples the live bytes at this many points of the training.
+            bool _allocations = false;
+            size_t _timeline = 0;
+            // runs of every configuration, for the comparisons
+            size_t _repeat = 1;
+            // when set, the samples of every configuration are recorded
+            // (counted in the training time) to a log of its own, see
+            // record_path; repeated runs overwrite it with the same samples.
+            std::string _record;
+            uint8_t _record_compression = sample_recorder_t::DELTA;
+        };
+
+        struct result_t {
+            std::string _workload;
+            std::string _learner;
+            size_t _dimen = 0, _labels = 0, _clouds = 0;
+            size_t _samples = 0;
+            bool _truncated = false;
+            double _seconds = 0;
+            double _samples_per_sec = 0;
+            // lookup latency in nanoseconds
+            double _lookup_p50 = 0, _lookup_p90 = 0, _lookup_p99 = 0;
+            size_t _nodes = 0;
+            // peak resident memory during the run, in KiB
+            size_t _peak_kb = 0;
+            // heap-traffic of the training, when tracked
+            bool _tracked = false;
+            double _allocs_per_sample = 0, _bytes_per_sample = 0;
+            int64_t _peak_live = 0, _live = 0;
+            // (samples, live bytes)
+            std::vector<std::pair<size_t, int64_t>> _timeline;
+        };
+
+        // trains a fresh vector of clouds of the named learner on the trace
+        // and measures it; false when the learner is unknown or its samples
+        // could not be recorded. The learner may be suffixed by @<memory>,
+        // see memory_names.
+        bool run(const std::string& learner, const trace_t& trace, const config_t& config, result_t& result);
+        const std::vector<std::string>& learner_names();
+        // memory resources of the learners (pmr.h): default (the global
+        // heap), pool (an unsynchronized pool per run) or monotonic (an arena
+        // per run, released at once).
+        const std::vector<std::string>& memory_names();
+        bool valid_learner(const std::string& learner);
+
+        enum class format_t {
+            TEXT, CSV, JSON
+        };
+
+        // writes results as they come, as an aligned table, CSV or a JSON
+        // array of objects.
+        class report_t {
+        public:
+            report_t(std::ostream& stream, format_t format, bool allocations = false);
+            ~report_t();
+            void add(const result_t& result);
+        private:
+            std::ostream& _stream;
+            format_t _format;
+            bool _allocations;
+            size_t _n = 0;
+        };
+
+        // the scaling-matrix; every combination of the parameters, on the
+        // sparse_mdp workload with dimen state-variables.
+        struct matrix_t {
+            std::vector<size_t> _dimens{1, 4, 16, 64, 256};
+            std::vector<size_t> _labels{1, 4, 32, 256, 1024};
+            std::vector<size_t> _clouds{1, 16, 256};
+            std::vector<size_t> _samples{10000};
+        };
+
+        // the log of the samples of a learner on a trace, next to base, e.g.
+        // base.sparse_mdp.MLearning@pool.d4.l32.c16.n10000
+        std::string record_path(const std::string& base, const std::string& learner, const trace_t& trace);
+
+        // false when a run failed, see run
+        bool run_matrix(const matrix_t& matrix, const std::vector<std::string>& learners, uint64_t seed,
+                const config_t& config, report_t& report, std::vector<result_t>& results);
+
+        // resident memory of the process, in KiB. The peak is reset where the
+        // platform allows it, otherwise it is the peak of the process.
+        size_t current_rss();
+        size_t peak_rss();
+        void reset_peak_rss();
+    }
+}
+
+#endif /* BENCH_BENCH_H */
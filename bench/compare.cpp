@@ -0,0 +1,230 @@
+/*
+ * Copyright Peter G. Jensen
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * File:   compare.cpp
+ * Author: Peter G. Jensen
+ *
+ * Created on October 17, 2026, 9:00 PM
+ */
+
+#include "compare.h"
+
+#include <boost/math/distributions/students_t.hpp>
+
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <map>
+#include <sstream>
+
+namespace prlearn {
+    namespace bench {
+
+        bool write_baseline(const std::string& path, const std::vector<result_t>& results) {
+            std::ofstream out(path, std::ios::trunc);
+            {
+                report_t report(out, format_t::CSV, true);
+                for (auto& r : results)
+                    report.add(r);
+            }
+            return (bool)out;
+        }
+
+        static std::vector<std::string> split(const std::string& line, char sep) {
+            std::vector<std::string> res;
+            std::stringstream ss(line);
+            std::string field;
+            while (std::getline(ss, field, sep))
+                res.push_back(field);
+            if (!line.empty() && line.back() == sep)
+                res.emplace_back();
+            return res;
+        }
+
+        bool read_baseline(const std::string& path, std::vector<result_t>& results) {
+            std::ifstream in(path);
+            std::string line;
+            if (!std::getline(in, line))
+                return false;
+            std::map<std::string, size_t> column;
+            auto header = split(line, ',');
+            for (size_t i = 0; i < header.size(); ++i)
+                column[header[i]] = i;
+            for (auto name :{"workload", "learner", "samples", "samples_per_sec"})
+                if (column.count(name) == 0)
+                    return false;
+
+            std::vector<result_t> res;
+            while (std::getline(in, line)) {
+                if (line.empty()) continue;
+                auto fields = split(line, ',');
+                auto get = [&](const char* name) -> const std::string& {
+                    static const std::string none;
+                    auto c = column.find(name);
+                    return c == column.end() || c->second >= fields.size() ? none : fields[c->second];
+                };
+                auto num = [&](const char* name) {
+                    return std::strtod(get(name).c_str(), nullptr);
+                };
+                result_t r;
+                r._workload = get("workload");
+                r._learner = get("learner");
+                r._dimen = num("dimen");
+                r._labels = num("labels");
+                r._clouds = num("clouds");
+                r._samples = num("samples");
+                r._truncated = num("truncated") != 0;
+                r._seconds = num("seconds");
+                r._samples_per_sec = num("samples_per_sec");
+                r._lookup_p50 = num("lookup_p50_ns");
+                r._lookup_p90 = num("lookup_p90_ns");
+                r._lookup_p99 = num("lookup_p99_ns");
+                r._nodes = num("nodes");
+                r._peak_kb = num("peak_kb");
+                r._allocs_per_sample = num("allocs_per_sample");
+                r._bytes_per_sample = num("bytes_per_sample");
+                r._peak_live = num("peak_live_bytes");
+                r._live = num("live_bytes");
+                r._tracked = r._peak_live > 0;
+                res.push_back(std::move(r));
+            }
+            results.swap(res);
+            return true;
+        }
+
+        namespace {
+
+            struct metric_t {
+                const char* _name;
+                double (*_get)(const result_t&);
+                bool _heap; // only when tracked
+                bool _higher_is_worse;
+            };
+
+            const metric_t metrics[] = {
+                {"samples_per_sec", [](const result_t & r) {
+                        return r._samples_per_sec; }, false, false},
+                {"lookup_p50_ns", [](const result_t & r) {
+                        return r._lookup_p50; }, false, true},
+                {"peak_kb", [](const result_t & r) {
+                        return (double) r._peak_kb; }, false, true},
+                {"allocs_per_sample", [](const result_t & r) {
+                        return r._allocs_per_sample; }, true, true},
+                {"bytes_per_sample", [](const result_t & r) {
+                        return r._bytes_per_sample; }, true, true},
+                {"peak_live_bytes", [](const result_t & r) {
+                        return (double) r._peak_live; }, true, true},
+            };
+
+            std::string key(const result_t& r) {
+                std::stringstream ss;
+                ss << r._workload << " " << r._learner << " d=" << r._dimen << " l=" << r._labels
+                        << " c=" << r._clouds << " n=" << r._samples;
+                return ss.str();
+            }
+
+            void moments(const std::vector<double>& xs, double& mean, double& var) {
+                mean = 0;
+                for (auto x : xs) mean += x;
+                mean /= xs.size();
+                var = 0;
+                for (auto x : xs) var += (x - mean) * (x - mean);
+                var = xs.size() > 1 ? var / (xs.size() - 1) : 0;
+            }
+
+            // one-sided p-value of current being worse than base (Welch)
+            double p_worse(const std::vector<double>& base, const std::vector<double>& current, bool higher_is_worse) {
+                double mb, vb, mc, vc;
+                moments(base, mb, vb);
+                moments(current, mc, vc);
+                double diff = higher_is_worse ? mc - mb : mb - mc;
+                double sb = vb / base.size(), sc = vc / current.size();
+                double se = std::sqrt(sb + sc);
+                if (se == 0)
+                    return diff > 0 ? 0 : 1;
+                double df = ((sb + sc) * (sb + sc)) /
+                        (((sb * sb) / (base.size() - 1)) + ((sc * sc) / (current.size() - 1)));
+                boost::math::students_t dist(df);
+                return boost::math::cdf(boost::math::complement(dist, diff / se));
+            }
+        }
+
+        size_t compare(const std::vector<result_t>& baseline, const std::vector<result_t>& current,
+                const compare_config_t& config, std::ostream& stream) {
+            std::map<std::string, std::pair<std::vector<const result_t*>, std::vector<const result_t*>>> groups;
+            for (auto& r : baseline)
+                groups[key(r)].first.push_back(&r);
+            for (auto& r : current)
+                groups[key(r)].second.push_back(&r);
+
+            auto flags = stream.flags();
+            auto precision = stream.precision();
+            stream << std::left << std::setw(52) << "configuration" << std::setw(20) << "metric"
+                    << std::right << std::setw(14) << "baseline" << std::setw(14) << "current"
+                    << std::setw(10) << "change" << std::setw(10) << "p" << "  verdict\n";
+            size_t regressions = 0;
+            for (auto& g : groups) {
+                auto& base = g.second.first;
+                auto& cur = g.second.second;
+                if (base.empty()) {
+                    stream << std::left << std::setw(52) << g.first << "  only in current\n";
+                    continue;
+                }
+                if (cur.empty()) {
+                    stream << std::left << std::setw(52) << g.first << "  only in baseline"
+                            << (config._allow_missing ? "\n" : "  MISSING\n");
+                    regressions += config._allow_missing ? 0 : 1;
+                    continue;
+                }
+                const bool tracked = base.front()->_tracked && cur.front()->_tracked;
+                for (auto& m : metrics) {
+                    if (m._heap && !tracked)
+                        continue;
+                    std::vector<double> xb, xc;
+                    for (auto r : base) xb.push_back(m._get(*r));
+                    for (auto r : cur) xc.push_back(m._get(*r));
+                    double mb, mc, v;
+                    moments(xb, mb, v);
+                    moments(xc, mc, v);
+                    double change = mb != 0 ? (mc - mb) / mb : (mc != 0 ? 1 : 0);
+                    double worse = m._higher_is_worse ? change : -change;
+                    bool testable = xb.size() > 1 && xc.size() > 1;
+                    double p = testable ? p_worse(xb, xc, m._higher_is_worse) : 0;
+                    bool regression = worse > config._threshold && p < config._alpha;
+                    if (std::string(m._name) == "peak_kb" && mc - mb < config._min_peak_kb)
+                        regression = false;
+                    regressions += regression ? 1 : 0;
+                    const char* verdict = regression ? "REGRESSION" :
+                            (worse < -config._threshold ? "improved" : "ok");
+                    stream << std::left << std::setw(52) << g.first << std::setw(20) << m._name
+                            << std::right << std::setprecision(6) << std::setw(14) << mb << std::setw(14) << mc
+                            << std::fixed << std::setprecision(1) << std::setw(9) << (change * 100) << "%"
+                            << std::setprecision(4) << std::setw(10);
+                    if (testable) stream << p;
+                    else stream << "-";
+                    stream.unsetf(std::ios::fixed);
+                    stream << "  " << verdict << "\n";
+                }
+            }
+            stream.flags(flags);
+            stream.precision(precision);
+            return regressions;
+        }
+    }
+}
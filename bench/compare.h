@@ -0,0 +1,65 @@
+/*
+ * Copyright Peter G. Jensen
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * File:   compare.h
+ * Author: Peter G. Jensen
+ *
+ * Created on October 17, 2026, 9:00 PM
+ */
+
+#ifndef BENCH_COMPARE_H
+#define BENCH_COMPARE_H
+
+#include "bench.h"
+
+#include <string>
+#include <vector>
+#include <ostream>
+
+namespace prlearn {
+    namespace bench {
+
+        // A baseline is the CSV output of the benchmark, one row per run;
+        // repeated runs (--repeat) of a configuration give the samples for
+        // the significance tests.
+        bool write_baseline(const std::string& path, const std::vector<result_t>& results);
+        bool read_baseline(const std::string& path, std::vector<result_t>& results);
+
+        struct compare_config_t {
+            // relative change that counts as a regression
+            double _threshold = 0.10;
+            // significance level of the (one-sided, Welch) t-test; with a
+            // single run on either side only the threshold is used.
+            double _alpha = 0.01;
+            // peak rss growth below this is ignored, in KiB
+            size_t _min_peak_kb = 1024;
+            // a configuration of the baseline which was not run is a
+            // failure, unless allowed
+            bool _allow_missing = false;
+        };
+
+        // compares the runs of every configuration present in both; time
+        // (throughput, lookup latency), memory (peak rss) and, when tracked
+        // in both, heap-traffic. Returns the number of regressions and
+        // missing configurations.
+        size_t compare(const std::vector<result_t>& baseline, const std::vector<result_t>& current,
+                const compare_config_t& config, std::ostream& stream);
+    }
+}
+
+#endif /* BENCH_COMPARE_H */
@@ -0,0 +1,332 @@
+/*
+ * Copyright Peter G. Jensen
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * File:   main.cpp
+ * Author: Peter G. Jensen
+ *
+ * Created on October 17, 2026, 6:10 PM
+ */
+
+#include "bench.h"
+#include "micro.h"
+#include "compare.h"
+#include "trace.h"
+#include "splitlog.h"
+#include "recorder.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <memory>
+
+using namespace prlearn::bench;
+
+static void usage(const char* name) {
+    std::cerr << "usage: " << name << " [options]\n"
+            << "  --workload <name>   gridworld, sparse_mdp or bandit (default all)\n"
+            << "  --learner <name>    QRefinementTree, QSimpleRegressor, MLearning or\n"
+            << "                      SimpleMLearning (default all), optionally with\n"
+            << "                      @<memory>, e.g. MLearning@pool\n"
+            << "  --memory <m,..>     run the learners with each memory resource; default,\n"
+            << "                      pool or monotonic\n"
+            << "  --samples <n,..>    samples per workload (default 20000)\n"
+            << "  --lookups <n>       timed lookups per run (default 10000)\n"
+            << "  --seed <n>          workload seed (default 1)\n"
+            << "  --threads <n>       propts_t::_threads (default 1)\n"
+            << "  --budget <seconds>  stop training a run after this long\n"
+            << "  --format <fmt>      text, csv or json (default text)\n"
+            << "  --allocations       count heap allocations during training\n"
+            << "  --timeline <n>      with --allocations, sample the live bytes n times\n"
+            << "  --repeat <n>        runs of every configuration (default 1)\n"
+            << "  --trace <file>      record the trace spans, as Chrome trace JSON\n"
+            << "  --split-log <file>  record the splits of all runs, see splitlog.h\n"
+            << "  --record <file>     record the samples of every configuration to a log\n"
+            << "                      of its own, <file>.<workload>.<learner>.d<dimen>...,\n"
+            << "                      see recorder.h\n"
+            << "  --record-compression <raw|delta|float|delta+float>\n"
+            << "                      of the recorded samples (default delta)\n"
+            << "\n"
+            << "  --save <file>       store the results as a baseline (CSV)\n"
+            << "  --compare <file>    compare with a baseline, exit with 2 on regressions;\n"
+            << "                      without --workload, --learner and --samples, those\n"
+            << "                      of the baseline are run\n"
+            << "  --threshold <pct>   relative change that is a regression (default 10)\n"
+            << "  --alpha <p>         significance level (default 0.01), needs --repeat\n"
+            << "                      of at least 2 on both sides\n"
+            << "  --allow-missing     configurations of the baseline which are not run\n"
+            << "                      are no failure\n"
+            << "\n"
+            << "  --matrix            scaling-matrix over the lists below, on sparse_mdp\n"
+            << "                      (default learners QRefinementTree, MLearning and\n"
+            << "                      SimpleMLearning, default samples 10000)\n"
+            << "  --dimens <n,..>     state dimensions (default 1,4,16,64,256)\n"
+            << "  --labels <n,..>     labels per cloud (default 1,4,32,256,1024)\n"
+            << "  --clouds <n,..>     number of clouds (default 1,16,256)\n"
+            << "\n"
+            << "  --micro             microbenchmarks of the kernels\n"
+            << "  --filter <text>     only kernels with text in their name\n"
+            << "  --warmup <n>        untimed repetitions (default 3)\n"
+            << "  --repetitions <n>   timed repetitions (default 15)\n"
+            << "  --cpu <n>           cpu to pin to, -1 for none (default 0)\n";
+}
+
+static std::vector<size_t> parse_list(const char* arg) {
+    std::vector<size_t> res;
+    while (*arg != '\0') {
+        char* end;
+        res.push_back(std::strtoull(arg, &end, 10));
+        if (end == arg) return {};
+        arg = *end == ',' ? end + 1 : end;
+    }
+    return res;
+}
+
+static std::vector<std::string> parse_names(const char* arg) {
+    std::vector<std::string> res;
+    std::string list = arg;
+    for (size_t start = 0; start <= list.size();) {
+        auto end = std::min(list.find(',', start), list.size());
+        res.push_back(list.substr(start, end - start));
+        start = end + 1;
+    }
+    return res;
+}
+
+// every learner without an explicit memory resource, with each of memories
+static void with_memory(std::vector<std::string>& learners, const std::vector<std::string>& memories) {
+    if (memories.empty()) return;
+    std::vector<std::string> res;
+    for (auto& l : learners) {
+        if (l.find('@') != std::string::npos) {
+            res.push_back(l);
+            continue;
+        }
+        for (auto& m : memories)
+            res.push_back(m == "default" ? l : l + "@" + m);
+    }
+    learners.swap(res);
+}
+
+int main(int argc, char** argv) {
+    std::vector<std::string> workloads, learners, memories;
+    std::vector<size_t> samples;
+    uint64_t seed = 1;
+    config_t config;
+    format_t format = format_t::TEXT;
+    bool matrix_mode = false;
+    matrix_t matrix;
+    bool micro_mode = false;
+    micro_config_t micro;
+    std::string save, against, trace_file, split_file, record_file;
+    uint8_t record_compression = prlearn::sample_recorder_t::DELTA;
+    compare_config_t compare_config;
+    for (int i = 1; i < argc; ++i) {
+        auto arg = argv[i];
+        const bool has_value = i + 1 < argc;
+        bool ok = true;
+        if (strcmp(arg, "--workload") == 0 && has_value)
+            workloads.emplace_back(argv[++i]);
+        else if (strcmp(arg, "--learner") == 0 && has_value)
+            learners.emplace_back(argv[++i]);
+        else if (strcmp(arg, "--memory") == 0 && has_value) {
+            memories = parse_names(argv[++i]);
+            for (auto& m : memories)
+                ok = ok && std::find(memory_names().begin(), memory_names().end(), m) != memory_names().end();
+        } else if (strcmp(arg, "--samples") == 0 && has_value)
+            ok = !(samples = parse_list(argv[++i])).empty();
+        else if (strcmp(arg, "--lookups") == 0 && has_value)
+            config._lookups = std::strtoull(argv[++i], nullptr, 10);
+        else if (strcmp(arg, "--seed") == 0 && has_value)
+            seed = std::strtoull(argv[++i], nullptr, 10);
+        else if (strcmp(arg, "--threads") == 0 && has_value)
+            config._options._threads = std::strtoull(argv[++i], nullptr, 10);
+        else if (strcmp(arg, "--budget") == 0 && has_value)
+            config._budget = std::strtod(argv[++i], nullptr);
+        else if (strcmp(arg, "--format") == 0 && has_value) {
+            std::string f = argv[++i];
+            if (f == "text") format = format_t::TEXT;
+            else if (f == "csv") format = format_t::CSV;
+            else if (f == "json") format = format_t::JSON;
+            else ok = false;
+        } else if (strcmp(arg, "--allocations") == 0)
+            config._allocations = true;
+        else if (strcmp(arg, "--timeline") == 0 && has_value)
+            config._timeline = std::strtoull(argv[++i], nullptr, 10);
+        else if (strcmp(arg, "--repeat") == 0 && has_value)
+            config._repeat = std::strtoull(argv[++i], nullptr, 10);
+        else if (strcmp(arg, "--trace") == 0 && has_value)
+            trace_file = argv[++i];
+        else if (strcmp(arg, "--split-log") == 0 && has_value)
+            split_file = argv[++i];
+        else if (strcmp(arg, "--record") == 0 && has_value)
+            record_file = argv[++i];
+        else if (strcmp(arg, "--record-compression") == 0 && has_value) {
+            std::string c = argv[++i];
+            if (c == "raw") record_compression = prlearn::sample_recorder_t::RAW;
+            else if (c == "delta") record_compression = prlearn::sample_recorder_t::DELTA;
+            else if (c == "float") record_compression = prlearn::sample_recorder_t::FLOAT;
+            else if (c == "delta+float") record_compression = prlearn::sample_recorder_t::DELTA | prlearn::sample_recorder_t::FLOAT;
+            else ok = false;
+        }
+        else if (strcmp(arg, "--save") == 0 && has_value)
+            save = argv[++i];
+        else if (strcmp(arg, "--compare") == 0 && has_value)
+            against = argv[++i];
+        else if (strcmp(arg, "--threshold") == 0 && has_value)
+            compare_config._threshold = std::strtod(argv[++i], nullptr) / 100;
+        else if (strcmp(arg, "--alpha") == 0 && has_value)
+            compare_config._alpha = std::strtod(argv[++i], nullptr);
+        else if (strcmp(arg, "--allow-missing") == 0)
+            compare_config._allow_missing = true;
+        else if (strcmp(arg, "--matrix") == 0)
+            matrix_mode = true;
+        else if (strcmp(arg, "--dimens") == 0 && has_value)
+            ok = !(matrix._dimens = parse_list(argv[++i])).empty();
+        else if (strcmp(arg, "--labels") == 0 && has_value)
+            ok = !(matrix._labels = parse_list(argv[++i])).empty();
+        else if (strcmp(arg, "--clouds") == 0 && has_value)
+            ok = !(matrix._clouds = parse_list(argv[++i])).empty();
+        else if (strcmp(arg, "--micro") == 0)
+            micro_mode = true;
+        else if (strcmp(arg, "--filter") == 0 && has_value)
+            micro._filter = argv[++i];
+        else if (strcmp(arg, "--warmup") == 0 && has_value)
+            micro._warmup = std::strtoull(argv[++i], nullptr, 10);
+        else if (strcmp(arg, "--repetitions") == 0 && has_value)
+            micro._repetitions = std::strtoull(argv[++i], nullptr, 10);
+        else if (strcmp(arg, "--cpu") == 0 && has_value)
+            micro._cpu = std::atoi(argv[++i]);
+        else
+            ok = false;
+        if (!ok) {
+            usage(argv[0]);
+            return strcmp(arg, "--help") == 0 ? 0 : 1;
+        }
+    }
+    for (auto& l : learners) {
+        if (!valid_learner(l)) {
+            std::cerr << "unknown learner " << l << std::endl;
+            return 1;
+        }
+    }
+
+    if (micro_mode) {
+        run_micro(micro, std::cout, format);
+        return 0;
+    }
+
+    std::vector<result_t> baseline;
+    if (!against.empty()) {
+        if (!read_baseline(against, baseline)) {
+            std::cerr << "could not read baseline " << against << std::endl;
+            return 1;
+        }
+        // run what the baseline has, unless told otherwise
+        if (!matrix_mode) {
+            auto add = [](std::vector<std::string>& list, const std::string& v) {
+                if (std::find(list.begin(), list.end(), v) == list.end()) list.push_back(v);
+            };
+            const bool w = workloads.empty(), l = learners.empty(), n = samples.empty();
+            for (auto& r : baseline) {
+                if (w) add(workloads, r._workload);
+                if (l) add(learners, r._learner);
+                if (n && std::find(samples.begin(), samples.end(), r._samples) == samples.end())
+                    samples.push_back(r._samples);
+            }
+        }
+    }
+
+    if (!trace_file.empty())
+        prlearn::trace::enable(true);
+    std::ofstream split_out;
+    std::unique_ptr<prlearn::split_stream_t> split_log;
+    if (!split_file.empty()) {
+        split_out.open(split_file, std::ios::binary);
+        split_log = std::make_unique<prlearn::split_stream_t>(split_out);
+        config._options._split_log = split_log.get();
+    }
+    config._record = record_file;
+    config._record_compression = record_compression;
+    std::vector<result_t> results;
+    if (matrix_mode) {
+        if (learners.empty()) learners = {"QRefinementTree", "MLearning", "SimpleMLearning"};
+        with_memory(learners, memories);
+        if (!samples.empty()) matrix._samples = samples;
+        report_t report(std::cout, format, config._allocations);
+        if (!run_matrix(matrix, learners, seed, config, report, results)) {
+            std::cerr << "could not write samples " << record_file << ".*" << std::endl;
+            return 1;
+        }
+    } else {
+        if (workloads.empty()) workloads = workload_names();
+        if (learners.empty()) learners = learner_names();
+        with_memory(learners, memories);
+        if (samples.empty()) samples = {20000};
+        for (auto& w : workloads) {
+            if (std::find(workload_names().begin(), workload_names().end(), w) == workload_names().end()) {
+                std::cerr << "unknown workload " << w << std::endl;
+                return 1;
+            }
+        }
+
+        report_t report(std::cout, format, config._allocations);
+        for (auto n : samples) {
+            for (auto& w : workloads) {
+                auto trace = make_workload(w, n, seed);
+                for (auto& l : learners) {
+                    for (size_t r = 0; r < std::max<size_t>(1, config._repeat); ++r) {
+                        result_t result;
+                        if (!run(l, trace, config, result)) {
+                            std::cerr << "could not write samples " << record_file << ".*" << std::endl;
+                            return 1;
+                        }
+                        report.add(result);
+                        results.push_back(std::move(result));
+                    }
+                }
+            }
+        }
+    }
+
+    if (!trace_file.empty()) {
+        prlearn::trace::enable(false);
+        std::ofstream out(trace_file);
+        prlearn::trace::write_chrome_json(out);
+        if (!out) {
+            std::cerr << "could not write trace " << trace_file << std::endl;
+            return 1;
+        }
+    }
+    if (!split_file.empty() && !split_out.flush()) {
+        std::cerr << "could not write split-log " << split_file << std::endl;
+        return 1;
+    }
+    if (!save.empty() && !write_baseline(save, results)) {
+        std::cerr << "could not write baseline " << save << std::endl;
+        return 1;
+    }
+    if (!against.empty()) {
+        std::cout << "\n";
+        auto regressions = compare(baseline, results, compare_config, std::cout);
+        std::cout << "\n" << regressions << " regression(s) or missing configuration(s)" << std::endl;
+        return regressions > 0 ? 2 : 0;
+    }
+    return 0;
+}
@@ -0,0 +1,365 @@
+/*
+ * Copyright Peter G. Jensen
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * File:   micro.cpp
+ * Author: Peter G. Jensen
+ *
+ * Created on October 17, 2026, 7:25 PM
+ */
+
+#include "micro.h"
+
+#include "MLearning.h"
+#include "RefinementTree.h"
+#include "structs.h"
+#include "threadpool.h"
+
+#include <algorithm>
+#include <chrono>
+#include <functional>
+#include <iostream>
+#include <iomanip>
+#include <random>
+#include <vector>
+
+#if defined(__linux__)
+#include <sched.h>
+#endif
+
+namespace prlearn {
+    namespace bench {
+
+        // the kernels under test are protected members
+        struct tree_access_t : public RefinementTree {
+            using RefinementTree::node_t;
+        };
+
+        struct mlearning_access_t : public MLearning {
+            using MLearning::interesect_t;
+        };
+
+        template<typename T>
+        static inline void keep(T& value) {
+#if defined(__GNUC__)
+            asm volatile("" : : "g"(&value) : "memory");
+#else
+            volatile auto sink = value;
+            (void) sink;
+#endif
+        }
+
+        bool pin_cpu(int cpu) {
+#if defined(__linux__)
+            cpu_set_t set;
+            CPU_ZERO(&set);
+            CPU_SET(cpu, &set);
+            return sched_setaffinity(0, sizeof (set), &set) == 0;
+#else
+            (void) cpu;
+            return false;
+#endif
+        }
+
+        namespace {
+
+            struct kernel_t {
+                std::string _name;
+                // does n operations
+                std::function<void(size_t) > _body;
+            };
+
+            struct timing_t {
+                std::string _name;
+                size_t _ops = 0;
+                double _median = 0, _min = 0, _max = 0;
+            };
+
+            using steady = std::chrono::steady_clock;
+
+            double elapsed(const std::function<void(size_t) >& body, size_t n) {
+                auto start = steady::now();
+                body(n);
+                return std::chrono::duration<double>(steady::now() - start).count();
+            }
+
+            timing_t measure(const kernel_t& kernel, const micro_config_t& config) {
+                size_t n = 1;
+                while (elapsed(kernel._body, n) < config._min_time && n < (((size_t) 1) << 40))
+                    n *= 2;
+                for (size_t i = 0; i < config._warmup; ++i)
+                    elapsed(kernel._body, n);
+                std::vector<double> ns;
+                for (size_t i = 0; i < std::max<size_t>(1, config._repetitions); ++i)
+                    ns.push_back(elapsed(kernel._body, n) * 1e9 / n);
+                std::sort(ns.begin(), ns.end());
+                timing_t res;
+                res._name = kernel._name;
+                res._ops = n;
+                res._median = ns[ns.size() / 2];
+                res._min = ns.front();
+                res._max = ns.back();
+                return res;
+            }
+
+            void splitfilter_kernels(std::vector<kernel_t>& kernels) {
+                // a differs from b by diff, all with the same count and
+                // variance; this selects the branch with the default options.
+                auto make = [](const char* name, double diff) {
+                    propts_t options;
+                    std::vector<qvar_t> pairs;
+                    std::mt19937_64 rng(1);
+                    std::uniform_real_distribution<double> jitter(0.95, 1.05);
+                    for (size_t i = 0; i < 16; ++i) {
+                        pairs.emplace_back(10, 20, 1);
+                        pairs.emplace_back(10 + (diff * jitter(rng)), 20, 1);
+                    }
+                    return kernel_t{name, [pairs, options](size_t n) {
+                            splitfilter_t filter;
+                            for (size_t i = 0; i < n; ++i) {
+                                auto j = 2 * (i % 16);
+                                filter.add(pairs[j], pairs[j + 1], options._indefference, options._lower_t,
+                                        options._upper_t, options._ks_limit, options._filter_rate);
+                            }
+                            keep(filter);
+                        }};
+                };
+                // t = diff / sqrt(2 / 20)
+                kernels.push_back(make("splitfilter_t::add/t-test", 1.0));
+                kernels.push_back(make("splitfilter_t::add/ks", 0.02));
+                kernels.push_back(make("splitfilter_t::add/no-op", 0.25));
+            }
+
+            // The split test of an MLearning node: one filter update per
+            // dimension, serially or spread over the pool in chunks as
+            // propts_t::_threads does; per node, to pick _parallel_dimen.
+            void split_test_kernels(std::vector<kernel_t>& kernels) {
+                for (size_t dimen :{16, 64, 128, 256, 1024}) {
+                    for (size_t threads :{1, 2, 4}) {
+                        auto filters = std::make_shared<std::vector<splitfilter_t>>(dimen);
+                        std::vector<qvar_t> pairs;
+                        std::mt19937_64 rng(4);
+                        std::uniform_real_distribution<double> diff(0, 1.5);
+                        for (size_t i = 0; i < dimen; ++i) {
+                            pairs.emplace_back(10, 20, 1);
+                            pairs.emplace_back(10 + diff(rng), 20, 1);
+                        }
+                        kernels.push_back({"split-test/dimen-" + std::to_string(dimen) + "/threads-" + std::to_string(threads),
+                            [filters, pairs, threads](size_t n) {
+                                propts_t o;
+                                auto& fs = *filters;
+                                auto update = [&](size_t i) {
+                                    fs[i].add(pairs[2 * i], pairs[2 * i + 1], o._indefference, o._lower_t,
+                                            o._upper_t, o._ks_limit, o._filter_rate);
+                                };
+                                const size_t dimen = fs.size();
+                                if (threads <= 1) {
+                                    for (size_t k = 0; k < n; ++k)
+                                        for (size_t i = 0; i < dimen; ++i)
+                                            update(i);
+                                } else {
+                                    auto& pool = threadpool_t::shared(threads);
+                                    const size_t chunks = std::min(dimen, std::min(threads, pool.size()) * 4);
+                                    const size_t width = (dimen + chunks - 1) / chunks;
+                                    for (size_t k = 0; k < n; ++k) {
+                                        pool.run(chunks, [&](size_t c) {
+                                            for (size_t i = c * width; i < std::min(dimen, (c + 1) * width); ++i)
+                                                update(i);
+                                        });
+                                    }
+                                }
+                                keep(fs);
+                            }});
+                    }
+                }
+            }
+
+            void qvar_kernels(std::vector<kernel_t>& kernels) {
+                std::vector<double> values(1024);
+                std::mt19937_64 rng(2);
+                std::uniform_real_distribution<double> unit(0, 10);
+                for (auto& v : values)
+                    v = unit(rng);
+                kernels.push_back({"qvar_t::operator+=", [values](size_t n) {
+                        qvar_t q;
+                        for (size_t i = 0; i < n; ++i)
+                            q += values[i % 1024];
+                        keep(q);
+                    }});
+                kernels.push_back({"qvar_t::addPoints(weight)", [values](size_t n) {
+                        qvar_t q;
+                        for (size_t i = 0; i < n; ++i)
+                            q.addPoints(1.5, values[i % 1024]);
+                        keep(q);
+                    }});
+                // per point, in batches of 64
+                kernels.push_back({"qvar_t::addPoints(batch-64)", [values](size_t n) {
+                        qvar_t q;
+                        for (size_t i = 0; i < n; i += 64)
+                            q.addPoints(values.data() + (i % 1024), nullptr, 64);
+                        keep(q);
+                    }});
+                // per element, on 64 elements
+                kernels.push_back({"qvar_array_t::add(64)", [values](size_t n) {
+                        qvar_array_t q(64);
+                        std::vector<double> side(64);
+                        for (size_t i = 0; i < 64; ++i)
+                            side[i] = (i % 3) == 0 ? 1 : 0;
+                        for (size_t i = 0; i < n; i += 64)
+                            q.add(values[(i / 64) % 1024], side.data());
+                        keep(q);
+                    }});
+
+                std::vector<qvar_t> pairs;
+                for (size_t i = 0; i < 64; ++i)
+                    pairs.emplace_back(values[i], 1 + (i % 7), values[i + 64]);
+                kernels.push_back({"qvar_t::approximate", [pairs](size_t n) {
+                        qvar_t res;
+                        for (size_t i = 0; i < n; ++i) {
+                            res = qvar_t::approximate(pairs[i % 64], pairs[(i + 1) % 64]);
+                            keep(res);
+                        }
+                    }});
+            }
+
+            void get_leaf_kernels(std::vector<kernel_t>& kernels) {
+                using node_t = tree_access_t::node_t;
+                constexpr size_t dimen = 4;
+                std::mt19937_64 rng(3);
+                std::uniform_real_distribution<double> unit(0, 1);
+                auto points = std::make_shared<std::vector<double>>(1024 * dimen);
+                for (auto& p : *points)
+                    p = unit(rng);
+                for (size_t depth :{1, 4, 8, 16}) {
+                    // a complete tree; level l splits dimension l % dimen in
+                    // the middle of the region, so every point is at depth.
+                    auto nodes = std::make_shared<std::pmr::vector<node_t>>((((size_t) 2) << depth) - 1);
+                    std::vector<double> lower(nodes->size() * dimen, 0), upper(nodes->size() * dimen, 1);
+                    for (size_t i = 0, level = 0; i + 1 < (((size_t) 1) << depth); ++i) {
+                        if (i > 0 && ((i + 1) & i) == 0) ++level;
+                        auto& split = (*nodes)[i]._split;
+                        split._is_split = true;
+                        split._var = level % dimen;
+                        split._boundary = (lower[i * dimen + split._var] + upper[i * dimen + split._var]) / 2;
+                        split._low = (2 * i) + 1;
+                        split._high = (2 * i) + 2;
+                        for (auto c :{split._low, split._high}) {
+                            std::copy_n(lower.begin() + (i * dimen), dimen, lower.begin() + (c * dimen));
+                            std::copy_n(upper.begin() + (i * dimen), dimen, upper.begin() + (c * dimen));
+                        }
+                        upper[split._low * dimen + split._var] = split._boundary;
+                        lower[split._high * dimen + split._var] = split._boundary;
+                    }
+                    kernels.push_back({"RefinementTree::get_leaf/depth-" + std::to_string(depth), [nodes, points](size_t n) {
+                            size_t sum = 0;
+                            for (size_t i = 0; i < n; ++i)
+                                sum += (*nodes)[0].get_leaf(points->data() + ((i % 1024) * dimen), 0, *nodes);
+                            keep(sum);
+                        }});
+                }
+            }
+
+            void intersection_kernels(std::vector<kernel_t>& kernels) {
+                using interesect_t = mlearning_access_t::interesect_t;
+                auto make = [](size_t size, size_t cloud, size_t last) {
+                    interesect_t res;
+                    res._size = size;
+                    res._cloud = cloud;
+                    std::shared_ptr<size_t[] > nodes(new size_t[size]);
+                    for (size_t i = 0; i < size; ++i)
+                        nodes[i] = i;
+                    if (size > 0)
+                        nodes[size - 1] = last;
+                    res._nodes = nodes;
+                    return res;
+                };
+                auto add = [&kernels](std::string name, interesect_t a, interesect_t b) {
+                    auto pair = std::make_shared<std::pair<interesect_t, interesect_t>>(std::move(a), std::move(b));
+                    kernels.push_back({std::move(name), [pair](size_t n) {
+                            size_t sum = 0;
+                            for (size_t i = 0; i < n; ++i) {
+                                auto& x = (i % 2) == 0 ? pair->first : pair->second;
+                                auto& y = (i % 2) == 0 ? pair->second : pair->first;
+                                keep(x);
+                                sum += x < y;
+                            }
+                            keep(sum);
+                        }});
+                };
+                add("interesect_t::operator</size", make(4, 1, 3), make(5, 1, 4));
+                add("interesect_t::operator</cloud", make(4, 1, 3), make(4, 2, 3));
+                // equal up to the last node
+                for (size_t size :{1, 8, 64})
+                    add("interesect_t::operator</nodes-" + std::to_string(size), make(size, 1, 1000), make(size, 1, 1001));
+            }
+        }
+
+        void run_micro(const micro_config_t& config, std::ostream& stream, format_t format) {
+            if (config._cpu >= 0 && !pin_cpu(config._cpu))
+                std::cerr << "could not pin to cpu " << config._cpu << std::endl;
+            std::vector<kernel_t> kernels;
+            splitfilter_kernels(kernels);
+            split_test_kernels(kernels);
+            qvar_kernels(kernels);
+            get_leaf_kernels(kernels);
+            intersection_kernels(kernels);
+
+            auto flags = stream.flags();
+            auto precision = stream.precision();
+            switch (format) {
+                case format_t::TEXT:
+                    stream << std::left << std::setw(40) << "kernel" << std::right << std::setw(14) << "ops/rep"
+                            << std::setw(12) << "median(ns)" << std::setw(12) << "min(ns)" << std::setw(12) << "max(ns)" << "\n";
+                    break;
+                case format_t::CSV:
+                    stream << "kernel,ops,median_ns,min_ns,max_ns\n";
+                    break;
+                case format_t::JSON:
+                    stream << "[";
+                    break;
+            }
+            size_t n = 0;
+            for (auto& k : kernels) {
+                if (k._name.find(config._filter) == std::string::npos)
+                    continue;
+                auto t = measure(k, config);
+                switch (format) {
+                    case format_t::TEXT:
+                        stream << std::left << std::setw(40) << t._name << std::right << std::fixed << std::setprecision(2)
+                                << std::setw(14) << t._ops << std::setw(12) << t._median << std::setw(12) << t._min
+                                << std::setw(12) << t._max << "\n";
+                        break;
+                    case format_t::CSV:
+                        stream << std::setprecision(6) << t._name << "," << t._ops << "," << t._median << ","
+                                << t._min << "," << t._max << "\n";
+                        break;
+                    case format_t::JSON:
+                        stream << std::setprecision(6) << (n > 0 ? ",\n" : "\n") << "  {\"kernel\": \"" << t._name
+                                << "\", \"ops\": " << t._ops << ", \"median_ns\": " << t._median
+                                << ", \"min_ns\": " << t._min << ", \"max_ns\": " << t._max << "}";
+                        break;
+                }
+                stream.flush();
+                ++n;
+            }
+            if (format == format_t::JSON)
+                stream << (n > 0 ? "\n]\n" : "]\n");
+            stream.flags(flags);
+            stream.precision(precision);
+        }
+    }
+}
@@ -0,0 +1,58 @@
+/*
+ * Copyright Peter G. Jensen
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * File:   micro.h
+ * Author: Peter G. Jensen
+ *
+ * Created on October 17, 2026, 7:25 PM
+ */
+
+#ifndef BENCH_MICRO_H
+#define BENCH_MICRO_H
+
+#include "bench.h"
+
+#include <string>
+#include <ostream>
+
+namespace prlearn {
+    namespace bench {
+
+        struct micro_config_t {
+            // only benchmarks whose name contains the filter
+            std::string _filter;
+            size_t _warmup = 3;
+            size_t _repetitions = 15;
+            // minimal duration of a repetition, in seconds; the number of
+            // operations per repetition is calibrated to reach it.
+            double _min_time = 0.01;
+            // -1 does not pin the thread
+            int _cpu = 0;
+        };
+
+        // Timings of the statistical and traversal kernels in isolation, on
+        // fixed inputs. Reports nanoseconds per operation (median, min and
+        // max over the repetitions).
+        void run_micro(const micro_config_t& config, std::ostream& stream, format_t format);
+
+        // pins the calling thread to a cpu, false where not supported
+        bool pin_cpu(int cpu);
+    }
+}
+
+#endif /* BENCH_MICRO_H */
@@ -0,0 +1,171 @@
+/*
+ * Copyright Peter G. Jensen
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * File:   workloads.cpp
+ * Author: Peter G. Jensen
+ *
+ * Created on October 17, 2026, 6:10 PM
+ */
+
+#include "workloads.h"
+
+#include <algorithm>
+#include <random>
+
+namespace prlearn {
+    namespace bench {
+
+        void trace_t::add(size_t cloud, const double* from, size_t label, size_t dest, const double* to, double cost) {
+            _cloud.push_back(cloud);
+            _label.push_back(label);
+            _dest.push_back(dest);
+            _cost.push_back(cost);
+            _from.insert(_from.end(), from, from + _dimen);
+            _to.insert(_to.end(), to, to + _dimen);
+        }
+
+        static void reserve(trace_t& trace, size_t samples) {
+            trace._cloud.reserve(samples);
+            trace._label.reserve(samples);
+            trace._dest.reserve(samples);
+            trace._cost.reserve(samples);
+            trace._from.reserve(samples * trace._dimen);
+            trace._to.reserve(samples * trace._dimen);
+        }
+
+        trace_t gridworld(size_t samples, uint64_t seed) {
+            trace_t trace;
+            trace._name = "gridworld";
+            trace._dimen = 2;
+            trace._n_clouds = 2;
+            trace._n_labels = 4;
+            reserve(trace, samples);
+
+            std::mt19937_64 rng(seed);
+            std::uniform_real_distribution<double> start(0, 5);
+            std::normal_distribution<double> noise(0, 0.3);
+            const double dx[] = {1, -1, 0, 0};
+            const double dy[] = {0, 0, 1, -1};
+            double s[2] = {start(rng), start(rng)};
+            size_t steps = 0;
+            while (trace.size() < samples) {
+                auto label = rng() % 4;
+                double t[2] = {
+                    std::min(10.0, std::max(0.0, s[0] + dx[label] + noise(rng))),
+                    std::min(10.0, std::max(0.0, s[1] + dy[label] + noise(rng)))
+                };
+                const bool goal = t[0] >= 9 && t[1] >= 9;
+                trace.add(1, s, label, goal ? 0 : 1, t, 1);
+                ++steps;
+                if (goal || steps >= 500) {
+                    s[0] = start(rng);
+                    s[1] = start(rng);
+                    steps = 0;
+                } else {
+                    s[0] = t[0];
+                    s[1] = t[1];
+                }
+            }
+            return trace;
+        }
+
+        trace_t sparse_mdp(size_t samples, uint64_t seed, size_t locations, size_t labels, size_t successors, size_t dimen) {
+            trace_t trace;
+            trace._name = "sparse_mdp";
+            trace._dimen = dimen;
+            trace._n_clouds = locations + 1;
+            trace._n_labels = labels;
+            reserve(trace, samples);
+
+            std::mt19937_64 rng(seed);
+            std::uniform_real_distribution<double> unit(0, 1);
+            std::normal_distribution<double> noise(0, 0.5);
+            // fixed model; successors and base-cost per action
+            std::vector<size_t> succ(locations * labels * successors);
+            std::vector<double> cost(locations * labels);
+            for (auto& s : succ)
+                s = 1 + (rng() % locations);
+            for (auto& c : cost)
+                c = 1 + 9 * unit(rng);
+
+            size_t loc = 1 + (rng() % locations);
+            std::vector<double> s(dimen), t(dimen);
+            for (auto& x : s)
+                x = unit(rng);
+            while (trace.size() < samples) {
+                auto label = rng() % labels;
+                auto action = (loc - 1) * labels + label;
+                size_t dest = unit(rng) < 0.01 ? 0 : succ[action * successors + (rng() % successors)];
+                for (size_t i = 0; i < dimen; ++i)
+                    t[i] = std::min(1.0, std::max(0.0, s[i] + 0.1 * noise(rng)));
+                trace.add(loc, s.data(), label, dest, t.data(), std::max(0.0, cost[action] + noise(rng) + s[0]));
+                if (dest == 0) {
+                    loc = 1 + (rng() % locations);
+                    for (auto& x : s)
+                        x = unit(rng);
+                } else {
+                    loc = dest;
+                    s.swap(t);
+                }
+            }
+            return trace;
+        }
+
+        trace_t bandit(size_t samples, uint64_t seed, size_t dimen, size_t labels) {
+            trace_t trace;
+            trace._name = "bandit";
+            trace._dimen = dimen;
+            trace._n_clouds = 2;
+            trace._n_labels = labels;
+            reserve(trace, samples);
+
+            std::mt19937_64 rng(seed);
+            std::uniform_real_distribution<double> unit(0, 1);
+            std::normal_distribution<double> noise(0, 1);
+            std::vector<double> weights(labels * dimen);
+            for (auto& w : weights)
+                w = unit(rng) < 0.25 ? 4 * unit(rng) : 0;
+            std::vector<double> s(dimen);
+            while (trace.size() < samples) {
+                for (auto& x : s)
+                    x = unit(rng);
+                auto label = rng() % labels;
+                double c = 1;
+                for (size_t i = 0; i < dimen; ++i)
+                    c += weights[label * dimen + i] * s[i];
+                trace.add(1, s.data(), label, 0, s.data(), std::max(0.0, c + noise(rng)));
+            }
+            return trace;
+        }
+
+        const std::vector<std::string>& workload_names() {
+            static const std::vector<std::string> names{"gridworld", "sparse_mdp", "bandit"};
+            return names;
+        }
+
+        trace_t make_workload(const std::string& name, size_t samples, uint64_t seed) {
+            if (name == "gridworld")
+                return gridworld(samples, seed);
+            if (name == "sparse_mdp")
+                return sparse_mdp(samples, seed);
+            if (name == "bandit")
+                return bandit(samples, seed);
+            return trace_t();
+        }
+    }
+}
@@ -0,0 +1,85 @@
+/*
+ * Copyright Peter G. Jensen
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * File:   workloads.h
+ * Author: Peter G. Jensen
+ *
+ * Created on October 17, 2026, 6:10 PM
+ */
+
+#ifndef BENCH_WORKLOADS_H
+#define BENCH_WORKLOADS_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace prlearn {
+    namespace bench {
+
+        // A pre-generated sequence of transitions, so generating the
+        // workload is not part of the measurements and every learner sees
+        // exactly the same samples. Cloud 0 is the sink. In every cloud the
+        // labels 0 .. _n_labels - 1 are enabled.
+        struct trace_t {
+            std::string _name;
+            size_t _dimen = 0;
+            size_t _n_clouds = 0;
+            size_t _n_labels = 0;
+            bool _minimization = true;
+            std::vector<size_t> _cloud, _label, _dest;
+            std::vector<double> _cost;
+            std::vector<double> _from, _to; // _dimen per transition
+
+            size_t size() const {
+                return _cloud.size();
+            }
+
+            const double* from(size_t i) const {
+                return _from.data() + i * _dimen;
+            }
+
+            const double* to(size_t i) const {
+                return _to.data() + i * _dimen;
+            }
+
+            void add(size_t cloud, const double* from, size_t label, size_t dest, const double* to, double cost);
+        };
+
+        // A point in [0, 10]^2 moved by four noisy actions until it reaches
+        // the goal-corner; one cloud (plus the sink), unit costs.
+        trace_t gridworld(size_t samples, uint64_t seed);
+
+        // locations * labels actions with a few fixed random successors each,
+        // random costs and a small chance of terminating; dimen noisy
+        // state-variables, the cost depends on the first.
+        trace_t sparse_mdp(size_t samples, uint64_t seed, size_t locations = 1000, size_t labels = 4,
+                size_t successors = 3, size_t dimen = 1);
+
+        // One-step episodes; the cost is linear in a uniform state with
+        // per-label weights, plus gaussian noise.
+        trace_t bandit(size_t samples, uint64_t seed, size_t dimen = 32, size_t labels = 16);
+
+        // any of the above by name, empty trace when unknown
+        trace_t make_workload(const std::string& name, size_t samples, uint64_t seed);
+        const std::vector<std::string>& workload_names();
+    }
+}
+
+#endif /* BENCH_WORKLOADS_H */
@@ -0,0 +1,181 @@
+/*
+ * Copyright Peter G. Jensen
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * File:   DenseRegressor.h
+ * Author: Peter G. Jensen
+ *
+ * Created on October 17, 2026, 4:30 PM
+ */
+
+#ifndef DENSEREGRESSOR_H
+#define DENSEREGRESSOR_H
+
+#include "propts.h"
+#include "structs.h"
+
+#include <limits>
+#include <vector>
+#include <map>
+#include <iomanip>
+#include <cstdint>
+#include <algorithm>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace prlearn {
+
+    // Same as SimpleRegressor, but for small dense sets of labels; the
+    // statistics are stored in arrays indexed directly by the label.
+    // For the best-Q, each label also keeps its value in a minimization and
+    // a maximization array where labels without a (finite) value are +/-inf,
+    // so best-Q is a plain (SIMD) min/max reduction.
+    class DenseRegressor {
+    public:
+        DenseRegressor() = default;
+        DenseRegressor(const DenseRegressor& other)
+        : _avg(other._avg, memory::current()), _var(other._var, memory::current()),
+        _n(other._n, memory::current()), _vmin(other._vmin, memory::current()),
+        _vmax(other._vmax, memory::current()), _valid(other._valid, memory::current()) {
+        }
+        DenseRegressor(DenseRegressor&&) = default;
+
+        qvar_t lookup(size_t label, const double*, size_t) const {
+            if (!valid(label))
+                return qvar_t{std::numeric_limits<double>::quiet_NaN(), 0, 0};
+            return qvar_t{_avg[label], (double) _n[label], _var[label]};
+        }
+
+        // number of labels, for statistics
+        size_t size() const {
+            return _n.size() - std::count(_n.begin(), _n.end(), 0);
+        }
+
+        // next_labels must be sorted, as for the SimpleRegressor.
+        double getBestQ(const double*, bool minimization, size_t* next_labels = nullptr, size_t n_labels = 0) const {
+            const auto& vals = minimization ? _vmin : _vmax;
+            if (next_labels == nullptr)
+                return reduce(vals.data(), nullptr, vals.size(), minimization);
+            double res = init(minimization);
+            for (size_t i = 0; i < n_labels && next_labels[i] < vals.size(); ++i)
+                res = minimization ? std::min(res, vals[next_labels[i]]) : std::max(res, vals[next_labels[i]]);
+            return res;
+        }
+
+        // best-Q over the labels set in mask, bit l of mask[l / 64] for label l.
+        double getBestQ(const uint64_t* mask, size_t n_labels, bool minimization) const {
+            const auto& vals = minimization ? _vmin : _vmax;
+            return reduce(vals.data(), mask, std::min(n_labels, vals.size()), minimization);
+        }
+
+        void update(size_t label, const double*, size_t, double nval, const double, const propts_t& options) {
+            if (label >= _n.size()) {
+                _avg.resize(label + 1, 0);
+                _var.resize(label + 1, 0);
+                _n.resize(label + 1, 0);
+                _vmin.resize(label + 1, init(true));
+                _vmax.resize(label + 1, init(false));
+                _valid.resize((label / 64) + 1, 0);
+            }
+            _valid[label / 64] |= ((uint64_t) 1) << (label % 64);
+            qvar_t v(_avg[label], std::min<size_t>(_n[label], options._q_learn_rate), _var[label]);
+            _n[label] += 1;
+            v += nval;
+            assert(v.avg() >= 0);
+            _avg[label] = v.avg();
+            _var[label] = v._variance;
+            const bool finite = !std::isinf(v.avg()) && !std::isnan(v.avg());
+            _vmin[label] = finite ? v.avg() : init(true);
+            _vmax[label] = finite ? v.avg() : init(false);
+        }
+
+        void print(std::ostream& s, size_t tabs, std::map<size_t, size_t>& label_map) const {
+            s << std::setprecision (std::numeric_limits<double>::digits10 + 1);
+            for (size_t i = 0; i < tabs; ++i) s << "\t";
+            s << "{";
+            bool first = true;
+            for (size_t l = 0; l < _n.size(); ++l) {
+                if (!valid(l)) continue;
+                if (!first) s << ",";
+                first = false;
+                s << "\n";
+                for (size_t t = 0; t < tabs; ++t) s << "\t";
+                s << "\"" << label_map[l] << "\" : ";
+                auto v = _avg[l];
+                if(!std::isinf(v) && !std::isnan(v))
+                    s << v;
+                else
+                    s << "\"inf\"";
+            }
+            s << "\n";
+            for (size_t i = 0; i < tabs; ++i) s << "\t";
+            s << "}";
+        }
+
+    protected:
+
+        static constexpr double init(bool minimization) {
+            return minimization ? std::numeric_limits<double>::infinity() :
+                    -std::numeric_limits<double>::infinity();
+        }
+
+        bool valid(size_t label) const {
+            return label < _n.size() && (_valid[label / 64] & (((uint64_t) 1) << (label % 64))) != 0;
+        }
+
+        static double reduce(const double* vals, const uint64_t* mask, size_t n, bool minimization) {
+            double res = init(minimization);
+            size_t i = 0;
+#if defined(__SSE2__)
+            // both lanes start out neutral; masked-out labels are blended to neutral
+            const __m128d neutral = _mm_set1_pd(res);
+            __m128d acc = neutral;
+            for (; i + 2 <= n; i += 2) {
+                __m128d v = _mm_loadu_pd(vals + i);
+                if (mask != nullptr) {
+                    const auto bits = (mask[i / 64] >> (i % 64)) & 3;
+                    const __m128d m = _mm_castsi128_pd(_mm_set_epi64x(
+                            (bits & 2) ? -1 : 0, (bits & 1) ? -1 : 0));
+                    v = _mm_or_pd(_mm_and_pd(m, v), _mm_andnot_pd(m, neutral));
+                }
+                acc = minimization ? _mm_min_pd(acc, v) : _mm_max_pd(acc, v);
+            }
+            double lanes[2];
+            _mm_storeu_pd(lanes, acc);
+            res = minimization ? std::min(lanes[0], lanes[1]) : std::max(lanes[0], lanes[1]);
+#endif
+            for (; i < n; ++i) {
+                if (mask != nullptr && (mask[i / 64] & (((uint64_t) 1) << (i % 64))) == 0)
+                    continue;
+                res = minimization ? std::min(res, vals[i]) : std::max(res, vals[i]);
+            }
+            return res;
+        }
+
+        // struct-of-arrays, indexed by label; in the resource current at
+        // construction, see pmr.h
+        std::pmr::vector<double> _avg{memory::current()}, _var{memory::current()};
+        std::pmr::vector<size_t> _n{memory::current()};
+        std::pmr::vector<double> _vmin{memory::current()}, _vmax{memory::current()};
+        std::pmr::vector<uint64_t> _valid{memory::current()};
+    };
+
+}
+#endif /* DENSEREGRESSOR_H */
+
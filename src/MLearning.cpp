@@ -24,6 +24,9 @@
 
 
 #include "MLearning.h"
+#include "threadpool.h"
+#include "trace.h"
+#include "splitlog.h"
 
 #include <vector>
 #include <memory>
@@ -33,6 +36,28 @@
 
 namespace prlearn {
 
+    static bool parallel_dimensions(size_t dimen, const propts_t& options) {
+        return options._threads > 1 && dimen >= options._parallel_dimen && dimen >= 2;
+    }
+
+    // calls fun(i) for all i < n, in chunks on the shared pool for wide nodes.
+    // fun(i) may only touch data belonging to i.
+    template<typename F>
+    static void for_each_dimension(size_t n, size_t dimen, const propts_t& options, F&& fun) {
+        if (!parallel_dimensions(dimen, options)) {
+            for (size_t i = 0; i < n; ++i)
+                fun(i);
+            return;
+        }
+        auto& pool = threadpool_t::shared(options._threads);
+        const size_t chunks = std::min(n, std::min(options._threads, pool.size()) * 4);
+        const size_t width = (n + chunks - 1) / chunks;
+        pool.run(chunks, [&](size_t c) {
+            for (size_t i = c * width; i < std::min(n, (c + 1) * width); ++i)
+                fun(i);
+        });
+    }
+
     bool MLearning::interesect_t::operator<(const interesect_t& other) const {
         if (_size != other._size) return _size < other._size;
         if (_cloud != other._cloud) return _cloud < other._cloud;
@@ -52,30 +77,260 @@ namespace prlearn {
         return false;
     }
 
-    MLearning::interesect_t::interesect_t(const interesect_t& other, size_t dimen) {
-        _size = other._size;
-        _cloud = other._cloud;
-        if (other._nodes != nullptr) {
-            _nodes = std::make_unique < size_t[]>(_size);
-            memcpy(_nodes.get(), other._nodes.get(), _size * sizeof (size_t));
+    void MLearning::interesect_t::split(size_t svar, qvar_t sv, double frac, double decay) {
+        // the current statistics become the old ones, or stay current
+        // but with a decayed weight.
+        assert(decay >= 0 && decay <= 1);
+        auto kind = varblock_t::OLD;
+        if (decay > 0) {
+            kind = varblock_t::VARIANCE;
+            _stats.clear(varblock_t::OLD);
+            frac *= decay;
+            sv.cnt() *= decay;
+        } else
+            _stats.make_old();
+        _stats.transform(kind, [&](size_t i, bool, qvar_t& v) {
+            if (i != svar)
+                v.cnt() = frac * v.cnt();
+        });
+        sv.cnt() = sv.cnt() / 2.0;
+        _stats.set(kind, svar, false, sv);
+        _stats.set(kind, svar, true, sv);
+    }
+
+    MLearning::varblock_t::varblock_t(const varblock_t& other) {
+        if (other._block == nullptr)
+            return;
+        auto dimen = other.dimen();
+        auto n = other.size(VARIANCE) + other.size(OLD);
+        auto ewords = 2 + 2 * bitmap_words(dimen);
+        _block = make_pmr_array<uint64_t>(ewords + (3 * n * sizeof (float) + 7) / 8);
+        memcpy(_block.get(), other._block.get(), ewords * sizeof (uint64_t));
+        _block[0] = dimen | ((uint64_t) n << 32);
+        memcpy(entries(), other.entries(), 3 * n * sizeof (float));
+    }
+
+    size_t MLearning::varblock_t::lowest(uint64_t bits) {
+        assert(bits != 0);
+#if defined(__GNUC__)
+        return __builtin_ctzll(bits);
+#else
+        size_t n = 0;
+        for (; (bits & 1) == 0; bits >>= 1) ++n;
+        return n;
+#endif
+    }
+
+    static inline size_t popcount(uint64_t bits) {
+#if defined(__GNUC__)
+        return __builtin_popcountll(bits);
+#else
+        size_t n = 0;
+        for (; bits != 0; bits &= bits - 1) ++n;
+        return n;
+#endif
+    }
+
+    size_t MLearning::varblock_t::dimen() const {
+        return _block ? (_block[0] & 0xFFFFFFFF) : 0;
+    }
+
+    size_t MLearning::varblock_t::capacity() const {
+        return _block ? (_block[0] >> 32) : 0;
+    }
+
+    size_t MLearning::varblock_t::size(kind_t kind) const {
+        if (_block == nullptr) return 0;
+        return kind == VARIANCE ? (_block[1] & 0xFFFFFFFF) : (_block[1] >> 32);
+    }
+
+    size_t MLearning::varblock_t::offset(kind_t kind) const {
+        return kind == VARIANCE ? 0 : size(VARIANCE);
+    }
+
+    void MLearning::varblock_t::resize(kind_t kind, size_t n) {
+        if (kind == VARIANCE)
+            _block[1] = (_block[1] & ~(uint64_t) 0xFFFFFFFF) | n;
+        else
+            _block[1] = (_block[1] & 0xFFFFFFFF) | ((uint64_t) n << 32);
+    }
+
+    const uint64_t* MLearning::varblock_t::bitmap(kind_t kind) const {
+        return _block.get() + 2 + kind * bitmap_words(dimen());
+    }
+
+    uint64_t* MLearning::varblock_t::bitmap(kind_t kind) {
+        return _block.get() + 2 + kind * bitmap_words(dimen());
+    }
+
+    const float* MLearning::varblock_t::entries() const {
+        return reinterpret_cast<const float*> (_block.get() + 2 + 2 * bitmap_words(dimen()));
+    }
+
+    float* MLearning::varblock_t::entries() {
+        return reinterpret_cast<float*> (_block.get() + 2 + 2 * bitmap_words(dimen()));
+    }
+
+    size_t MLearning::varblock_t::rank(kind_t kind, size_t bit) const {
+        auto bm = bitmap(kind);
+        size_t r = offset(kind);
+        for (size_t w = 0; w < bit / 64; ++w)
+            r += popcount(bm[w]);
+        if (bit % 64 != 0)
+            r += popcount(bm[bit / 64] & ((((uint64_t) 1) << (bit % 64)) - 1));
+        return r;
+    }
+
+    void MLearning::varblock_t::reserve(size_t cap) {
+        auto dimen = this->dimen();
+        assert(dimen > 0);
+        if (cap <= capacity()) return;
+        auto ewords = 2 + 2 * bitmap_words(dimen);
+        auto n = size(VARIANCE) + size(OLD);
+        auto nblock = make_pmr_array<uint64_t>(ewords + (3 * cap * sizeof (float) + 7) / 8,
+                _block.get_deleter().resource());
+        memcpy(nblock.get(), _block.get(), (ewords * sizeof (uint64_t)) + (3 * n * sizeof (float)));
+        nblock[0] = dimen | ((uint64_t) cap << 32);
+        _block.swap(nblock);
+    }
+
+    void MLearning::varblock_t::init(size_t dimen) {
+        if (_block != nullptr) {
+            assert(this->dimen() == dimen);
+            return;
         }
+        assert(dimen < ((uint64_t) 1 << 31));
+        // one half per dimension is what a single sample fills
+        auto ewords = 2 + 2 * bitmap_words(dimen);
+        _block = make_pmr_array<uint64_t>(ewords + (3 * dimen * sizeof (float) + 7) / 8);
+        _block[0] = dimen | ((uint64_t) dimen << 32);
+    }
 
-        assert(_size == 0 || this->_nodes != nullptr);
-        assert(_cloud != 0 || _size == 0);
+    bool MLearning::varblock_t::has(kind_t kind) const {
+        return size(kind) > 0;
+    }
 
-        if (other._variance != nullptr) {
-            _variance = std::make_unique < std::pair<qvar_t, qvar_t>[]>(dimen);
-            for (size_t i = 0; i < dimen; ++i) {
-                _variance[i] = other._variance[i];
-                assert(_variance[i].first.avg() == other._variance[i].first.avg());
-                assert(_variance[i].second.avg() == other._variance[i].second.avg());
+    qvar_t MLearning::varblock_t::get(kind_t kind, size_t dim, bool high) const {
+        if (!has(kind)) return qvar_t();
+        assert(dim < dimen());
+        auto bit = 2 * dim + (high ? 1 : 0);
+        if ((bitmap(kind)[bit / 64] & (((uint64_t) 1) << (bit % 64))) == 0)
+            return qvar_t();
+        auto e = entries() + 3 * rank(kind, bit);
+        return qvar_t(e[0], e[1], e[2]);
+    }
+
+    void MLearning::varblock_t::set(kind_t kind, size_t dim, bool high, const qvar_t& value) {
+        assert(_block != nullptr);
+        assert(dim < dimen());
+        auto bit = 2 * dim + (high ? 1 : 0);
+        auto mask = ((uint64_t) 1) << (bit % 64);
+        auto idx = rank(kind, bit);
+        auto n = size(VARIANCE) + size(OLD);
+        bool present = (bitmap(kind)[bit / 64] & mask) != 0;
+        if (value.cnt() == 0) {
+            // empty halves are not stored at all
+            if (present) {
+                auto e = entries();
+                memmove(e + 3 * idx, e + 3 * (idx + 1), 3 * (n - idx - 1) * sizeof (float));
+                bitmap(kind)[bit / 64] &= ~mask;
+                resize(kind, size(kind) - 1);
             }
+            return;
         }
-        if (other._old != nullptr) {
-            _old = std::make_unique < std::pair<qvar_t, qvar_t>[]>(dimen);
-            for (size_t i = 0; i < dimen; ++i)
-                _old[i] = other._old[i];
+        if (!present) {
+            if (n == capacity())
+                reserve(std::max(n + 1, n + n / 2));
+            auto e = entries();
+            memmove(e + 3 * (idx + 1), e + 3 * idx, 3 * (n - idx) * sizeof (float));
+            bitmap(kind)[bit / 64] |= mask;
+            resize(kind, size(kind) + 1);
         }
+        auto e = entries() + 3 * idx;
+        e[0] = value.avg();
+        e[1] = value.cnt();
+        e[2] = value._variance;
+    }
+
+    void MLearning::varblock_t::add(kind_t kind, size_t dim, bool high, double value) {
+        auto v = get(kind, dim, high);
+        v += value;
+        set(kind, dim, high, v);
+    }
+
+    void MLearning::varblock_t::clear(kind_t kind, size_t dim) {
+        if (!has(kind)) return;
+        set(kind, dim, false, qvar_t());
+        set(kind, dim, true, qvar_t());
+    }
+
+    void MLearning::varblock_t::make_old() {
+        if (!has(VARIANCE)) {
+            clear(OLD);
+            return;
+        }
+        // the old entries are stored last, so dropping them is a truncation
+        auto words = bitmap_words(dimen());
+        memcpy(bitmap(OLD), bitmap(VARIANCE), words * sizeof (uint64_t));
+        memset(bitmap(VARIANCE), 0, words * sizeof (uint64_t));
+        resize(OLD, size(VARIANCE));
+        resize(VARIANCE, 0);
+    }
+
+    void MLearning::varblock_t::write(std::ostream& s) const {
+        uint64_t dimen = this->dimen();
+        write_binary(s, &dimen);
+        if (dimen == 0) return;
+        uint64_t sizes[2] = {size(VARIANCE), size(OLD)};
+        write_binary(s, sizes, 2);
+        write_binary(s, _block.get() + 2, 2 * bitmap_words(dimen));
+        write_binary(s, entries(), 3 * (sizes[0] + sizes[1]));
+    }
+
+    bool MLearning::varblock_t::read(std::istream& s, size_t expected) {
+        _block = nullptr;
+        uint64_t dimen, sizes[2];
+        if (!read_binary(s, &dimen)) return false;
+        if (dimen == 0) return true;
+        if (dimen != expected || !read_binary(s, sizes, 2) || sizes[0] > 2 * dimen || sizes[1] > 2 * dimen)
+            return false;
+        auto n = sizes[0] + sizes[1];
+        auto words = bitmap_words(dimen);
+        _block = make_pmr_array<uint64_t>(2 + 2 * words + (3 * n * sizeof (float) + 7) / 8);
+        _block[0] = dimen | (n << 32);
+        _block[1] = sizes[0] | (sizes[1] << 32);
+        if (!read_binary(s, _block.get() + 2, 2 * words))
+            return false;
+        // the bitmaps index the entries, so they must agree with the sizes
+        for (auto kind :{VARIANCE, OLD}) {
+            auto bm = bitmap(kind);
+            size_t bits = 0;
+            for (size_t w = 0; w < words; ++w)
+                bits += popcount(bm[w]);
+            if (bits != sizes[kind] || ((2 * dimen) % 64 != 0 && (bm[words - 1] >> ((2 * dimen) % 64)) != 0))
+                return false;
+        }
+        if (!read_binary(s, entries(), 3 * n))
+            return false;
+        // empty halves are never stored, see set
+        auto e = entries();
+        for (size_t i = 0; i < n; ++i, e += 3) {
+            if (std::isnan(e[0]) || !(e[1] > 0) || !std::isfinite(e[1]) || std::isnan(e[2]))
+                return false;
+        }
+        return true;
+    }
+
+    void MLearning::varblock_t::clear(kind_t kind) {
+        if (!has(kind)) return;
+        if (kind == VARIANCE) {
+            auto e = entries();
+            memmove(e, e + 3 * size(VARIANCE), 3 * size(OLD) * sizeof (float));
+        }
+        memset(bitmap(kind), 0, bitmap_words(dimen()) * sizeof (uint64_t));
+        resize(kind, 0);
+        if (!has(VARIANCE) && !has(OLD))
+            _block = nullptr;
     }
 
     MLearning::node_t::node_t(const node_t& other, size_t dimen) {
@@ -84,10 +339,17 @@ namespace prlearn {
         _old = other._old;
         _samples.reserve(other._samples.size());
         _parent = other._parent;
-        for (auto& s : other._samples)
-            _samples.emplace_back(s, dimen);
+        for (auto& s : other._samples) {
+            _samples.emplace_back(s);
+            if (s._nodes) {
+                // not shared with the original, which may be freed first
+                auto nodes = make_pmr_array<size_t>(s._size);
+                std::copy_n(s._nodes.get(), s._size, nodes.get());
+                _samples.back()._nodes = share_pmr_array(std::move(nodes));
+            }
+        }
         if (other._data) {
-            _data = std::make_unique < data_t[]>(dimen);
+            _data = make_pmr_array<data_t>(dimen);
             for (size_t i = 0; i < dimen; ++i)
                 _data[i] = other._data[i];
         }
@@ -103,12 +365,23 @@ namespace prlearn {
     MLearning::MLearning() {
     }
 
+    std::vector<size_t> MLearning::labels() const {
+        std::vector<size_t> res;
+        res.reserve(_mapping.size());
+        for (auto& m : _mapping)
+            res.push_back(m._label);
+        std::sort(res.begin(), res.end());
+        return res;
+    }
+
     void MLearning::addSample(size_t dimen, const double* f_var,
             const double* t_var, size_t*, size_t,
             size_t label,
             size_t dest, double value, const std::vector<MLearning>& clouds,
             bool minimization, const double delta,
             const propts_t& options) {
+        PRLEARN_TRACE_SPAN("MLearning::addSample");
+        memory::scope_t scope(_nodes.get_allocator().resource());
         _dimen = dimen;
         el_t lf((size_t) label);
         auto res = _mapping.end();
@@ -127,10 +400,14 @@ namespace prlearn {
 
         assert(res->_label == (size_t) label);
 
-        auto node = _nodes[res->_nid].find_node(_nodes, f_var, res->_nid);
+        size_t node;
+        {
+            PRLEARN_TRACE_SPAN("MLearning::descent");
+            node = _nodes[res->_nid].find_node(_nodes, f_var, res->_nid);
+        }
         assert(node < _nodes.size());
         _nodes[node].add_sample(dest, f_var, t_var, value, _dimen, clouds);
-        _nodes[node].update(node, minimization, clouds, _nodes, dimen, true, delta, options);
+        _nodes[node].update(node, label, minimization, clouds, _nodes, dimen, true, delta, options);
 
         if (_mapping.size() <= 1) return;
         auto bv = std::numeric_limits<double>::infinity();
@@ -161,10 +438,11 @@ namespace prlearn {
                     rnd = nn;
             }
         }
+        // no splits without allowSplit, so label is never logged for these
         for (auto best_alt : best)
-            _nodes[best_alt].update(best_alt, minimization, clouds, _nodes, dimen, false, delta, options);
+            _nodes[best_alt].update(best_alt, label, minimization, clouds, _nodes, dimen, false, delta, options);
         if (fcnt > 0)
-            _nodes[rnd].update(rnd, minimization, clouds, _nodes, dimen, false, delta, options);
+            _nodes[rnd].update(rnd, label, minimization, clouds, _nodes, dimen, false, delta, options);
     }
 
     qvar_t MLearning::lookup(size_t label, const double* f_var, size_t) const {
@@ -197,7 +475,7 @@ namespace prlearn {
         s << "}";
     }
 
-    void MLearning::node_t::print(std::ostream& s, size_t tabs, const std::vector<node_t>& nodes) const {
+    void MLearning::node_t::print(std::ostream& s, size_t tabs, const std::pmr::vector<node_t>& nodes) const {
         for (size_t i = 0; i < tabs; ++i) s << "\t";
         if (_split._is_split) {
             s << "{\"var\":" << _split._var << ",\"bound\":" << _split._boundary << ",\n";
@@ -230,17 +508,19 @@ namespace prlearn {
     {
     }
 
-    std::unique_ptr<size_t[] > MLearning::findIntersection(const double* point) const {
-        auto target = std::make_unique < size_t[]>(_mapping.size());
+    pmr_array_t<size_t> MLearning::findIntersection(const double* point) const {
+        auto target = make_pmr_array<size_t>(_mapping.size());
         for (size_t i = 0; i < _mapping.size(); ++i) {
             target[i] = _nodes[_mapping[i]._nid].find_node(_nodes, point, _mapping[i]._nid);
         }
         return target;
     }
 
-    std::pair<qvar_t, qvar_t> MLearning::node_t::aggregate_samples(const std::vector<MLearning>& clouds, size_t dimen, bool minimize, std::pair<qvar_t, qvar_t>* tmpq, double discount) {
+    std::pair<qvar_t, qvar_t> MLearning::node_t::aggregate_samples(const std::vector<MLearning>& clouds, size_t dimen, bool minimize, std::pair<qvar_t, qvar_t>* tmpq, const propts_t& options) {
+        PRLEARN_TRACE_SPAN("MLearning::aggregate_samples");
+        const auto discount = options._discount;
         avg_t mean, old_mean;
-        std::vector<qvar_t> sample_qvar;
+        std::vector<std::pair<size_t, qvar_t>> sample_qvar;
         std::vector<qvar_t> old_var;
         double fut = 0;
         for (auto& s : _samples) {
@@ -270,60 +550,61 @@ namespace prlearn {
             // dont look too far into the future for the variance.
             // if we do, it will grow in horrible ways and be useless.
             var *= std::min(0.5, discount);
-            for (size_t d = 0; d < dimen; ++d) {
-                if (s._variance) {
-                    auto v = s._variance[d];
-                    v.first.avg() += best;
-                    v.second.avg() += best;
-                    v.first._variance = std::max(v.first._variance, var);
-                    v.second._variance = std::max(v.second._variance, var);
-                    tmpq[d].first.addPoints(v.first.cnt(), v.first.avg());
-                    tmpq[d].second.addPoints(v.second.cnt(), v.second.avg());
-                    mean.addPoints(v.first.cnt(), v.first.avg());
-                    mean.addPoints(v.second.cnt(), v.second.avg());
-                    sample_qvar.emplace_back(v.first);
-                    sample_qvar.emplace_back(v.second);
-                }
-                if (s._old) {
-                    auto v = s._old[d];
-                    v.first.avg() += best;
-                    v.second.avg() += best;
-                    v.first._variance = std::max(v.first._variance, var);
-                    v.second._variance = std::max(v.second._variance, var);
-                    old_mean.addPoints(v.first.cnt(), v.first.avg());
-                    old_mean.addPoints(v.second.cnt(), v.second.avg());
-                    old_var.push_back(v.first);
-                    old_var.push_back(v.second);
-                }
-            }
+            // empty halves are not stored and would not contribute anyhow.
+            s._stats.for_each(varblock_t::VARIANCE, [&](size_t d, bool high, qvar_t v) {
+                v.avg() += best;
+                v._variance = std::max(v._variance, var);
+                if (high)
+                    tmpq[d].second.addPoints(v.cnt(), v.avg());
+                else
+                    tmpq[d].first.addPoints(v.cnt(), v.avg());
+                mean.addPoints(v.cnt(), v.avg());
+                sample_qvar.emplace_back(high ? dimen + d : d, v);
+            });
+            s._stats.for_each(varblock_t::OLD, [&](size_t, bool, qvar_t v) {
+                v.avg() += best;
+                v._variance = std::max(v._variance, var);
+                old_mean.addPoints(v.cnt(), v.avg());
+                old_var.push_back(v);
+            });
         }
 
         avg_t svar, ovar;
         auto vars = std::make_unique < avg_t[]>(dimen * 2);
-        bool first = true;
-        size_t dimcnt = 0;
-        for (auto& s : sample_qvar) {
-            {
-                const auto dif = std::abs(s.avg() - mean._avg);
-                const auto std = std::sqrt(s._variance);
-                auto var = (std::pow(dif + std, 2.0) + std::pow(dif - std, 2.0)) / 2.0;
-                svar.addPoints(s.cnt(), var);
-            }
-            auto id = dimcnt;
-            auto dmin = tmpq[id].first.avg();
-            if (!first) {
-                dmin = tmpq[dimcnt].second.avg();
-                id = dimen + dimcnt;
-            }
-            {
-                const auto dif = std::abs(s.avg() - dmin);
-                const auto std = std::sqrt(s._variance);
-                auto var = (std::pow(dif + std, 2.0) + std::pow(dif - std, 2.0)) / 2.0;
-                vars[id].addPoints(s.cnt(), var);
-            }
-            if (!first)
-                dimcnt = (dimcnt + 1) % dimen;
-            first = !first;
+        for (auto& sq : sample_qvar) {
+            auto& s = sq.second;
+            const auto dif = std::abs(s.avg() - mean._avg);
+            const auto std = std::sqrt(s._variance);
+            auto var = (std::pow(dif + std, 2.0) + std::pow(dif - std, 2.0)) / 2.0;
+            svar.addPoints(s.cnt(), var);
+        }
+
+        auto fold = [&](size_t id, const qvar_t & s) {
+            auto dmin = id < dimen ? tmpq[id].first.avg() : tmpq[id - dimen].second.avg();
+            const auto dif = std::abs(s.avg() - dmin);
+            const auto std = std::sqrt(s._variance);
+            auto var = (std::pow(dif + std, 2.0) + std::pow(dif - std, 2.0)) / 2.0;
+            vars[id].addPoints(s.cnt(), var);
+        };
+        if (!parallel_dimensions(dimen, options)) {
+            for (auto& sq : sample_qvar)
+                fold(sq.first, sq.second);
+        } else {
+            // group the halves by id (stable), so each id is folded in the
+            // same order as above, just on its own.
+            std::vector<size_t> offset(dimen * 2 + 1, 0);
+            std::vector<size_t> order(sample_qvar.size());
+            for (auto& sq : sample_qvar)
+                ++offset[sq.first + 1];
+            for (size_t id = 0; id < dimen * 2; ++id)
+                offset[id + 1] += offset[id];
+            auto pos = offset;
+            for (size_t i = 0; i < sample_qvar.size(); ++i)
+                order[pos[sample_qvar[i].first]++] = i;
+            for_each_dimension(dimen * 2, dimen, options, [&](size_t id) {
+                for (size_t i = offset[id]; i < offset[id + 1]; ++i)
+                    fold(id, sample_qvar[order[i]].second);
+            });
         }
 
         for (auto& s : old_var) {
@@ -343,7 +624,7 @@ namespace prlearn {
         return std::make_pair(nq, oq);
     }
 
-    void MLearning::node_t::update_parents(std::vector<node_t>& nodes, size_t next, bool minimize) {
+    void MLearning::node_t::update_parents(std::pmr::vector<node_t>& nodes, size_t next, bool minimize) {
         if (!nodes[next]._split._is_split)
             return;
 
@@ -357,34 +638,67 @@ namespace prlearn {
         update_parents(nodes, nodes[next]._parent, minimize);
     }
 
+    void MLearning::findRegion(const size_t* nodes, size_t n, double* lower, double* upper) const {
+        // lower is exclusive, upper is inclusive; see find_node
+        for (size_t d = 0; d < _dimen; ++d) {
+            lower[d] = -std::numeric_limits<double>::infinity();
+            upper[d] = std::numeric_limits<double>::infinity();
+        }
+        for (size_t i = 0; i < n; ++i) {
+            auto next = nodes[i];
+            while (_nodes[next]._parent != next) {
+                auto& split = _nodes[_nodes[next]._parent]._split;
+                assert(split._is_split);
+                if (split._low == next)
+                    upper[split._var] = std::min(upper[split._var], split._boundary);
+                else
+                    lower[split._var] = std::max(lower[split._var], split._boundary);
+                next = _nodes[next]._parent;
+            }
+        }
+    }
+
+    size_t MLearning::findContainer(size_t root, const double* lower, const double* upper) const {
+        auto next = root;
+        while (_nodes[next]._split._is_split) {
+            auto& split = _nodes[next]._split;
+            if (upper[split._var] <= split._boundary)
+                next = split._low;
+            else if (lower[split._var] >= split._boundary)
+                next = split._high;
+            else
+                break;
+        }
+        return next;
+    }
+
     void MLearning::node_t::tighten_samples(const std::vector<MLearning>& clouds, size_t) {
-        size_t i = 0;
-        while (i < _samples.size()) {
-            auto pointsize = clouds[_samples[i]._cloud]._mapping.size();
+        PRLEARN_TRACE_SPAN("MLearning::tighten_samples");
+        bool changed = false;
+        std::vector<double> bounds;
+        for (auto& s : _samples) {
+            auto& cloud = clouds[s._cloud];
+            auto pointsize = cloud._mapping.size();
 
-            assert(_samples[i]._size <= pointsize);
-            if (pointsize == _samples[i]._size) {
-                ++i;
+            assert(s._size <= pointsize);
+            if (pointsize == s._size)
                 continue;
-            }
-            interesect_t tmp;
-            tmp._size = pointsize;
-            tmp._nodes = std::make_unique < size_t[]>(pointsize);
-            tmp._cloud = _samples[i]._cloud;
-            tmp._variance.swap(_samples[i]._variance);
-            tmp._old.swap(_samples[i]._old);
-            memcpy(tmp._nodes.get(), _samples[i]._nodes.get(), _samples[i]._size * sizeof (size_t));
-            for (size_t j = _samples[i]._size; j < pointsize; ++j) {
-                // TODO, improve, we know it has to be the smallest super-set node of the other nodes.
-                auto& el = clouds[_samples[i]._cloud]._mapping[j];
-                tmp._nodes[j] = el._nid;
-            }
-
-            _samples.erase(_samples.begin() + i);
-            auto lb = std::lower_bound(_samples.begin(), _samples.end(), tmp);
-            lb = _samples.emplace(lb, std::move(tmp));
-            assert(lb->_size == pointsize);
+            changed = true;
+            // the new labels get the smallest node which is known to
+            // contain the region spanned by the existing nodes.
+            bounds.resize(cloud._dimen * 2);
+            cloud.findRegion(s._nodes.get(), s._size, bounds.data(), bounds.data() + cloud._dimen);
+            auto nodes = make_pmr_array<size_t>(pointsize);
+            if (s._size > 0)
+                memcpy(nodes.get(), s._nodes.get(), s._size * sizeof (size_t));
+            for (size_t j = s._size; j < pointsize; ++j)
+                nodes[j] = cloud.findContainer(cloud._mapping[j]._nid, bounds.data(), bounds.data() + cloud._dimen);
+            s._nodes = share_pmr_array(std::move(nodes));
+            s._size = pointsize;
         }
+        // restore the order once instead of re-inserting per sample
+        if (changed)
+            std::sort(_samples.begin(), _samples.end());
     }
 
     void MLearning::node_t::add_sample(size_t dest, const double* f_var, const double* t_var, double value, size_t dimen, const std::vector<MLearning>& clouds) {
@@ -392,7 +706,7 @@ namespace prlearn {
         auto lb = _samples.begin();
         {
             interesect_t tmp;
-            tmp._nodes = clouds[dest].findIntersection(t_var);
+            tmp._nodes = share_pmr_array(clouds[dest].findIntersection(t_var));
             tmp._cloud = dest;
             tmp._size = clouds[dest]._mapping.size();
             lb = std::lower_bound(_samples.begin(), _samples.end(), tmp);
@@ -400,36 +714,29 @@ namespace prlearn {
                 lb = _samples.emplace(lb, std::move(tmp));
         }
 
-        if (lb->_variance == nullptr) {
-            lb->_variance = std::make_unique < std::pair<qvar_t, qvar_t>[]>(dimen);
-            for (size_t i = 0; i < dimen; ++i) {
-                assert(lb->_variance[i].first.avg() == 0);
-                assert(lb->_variance[i].first.cnt() == 0);
-                assert(lb->_variance[i].second.avg() == 0);
-                assert(lb->_variance[i].second.cnt() == 0);
-            }
-        }
+        lb->_stats.init(dimen);
         if (_data == nullptr)
-            _data = std::make_unique < data_t[]>(dimen);
+            _data = make_pmr_array<data_t>(dimen);
 
         for (size_t d = 0; d < dimen; ++d) {
             if (f_var[d] <= _data[d]._mid._avg) {
-                lb->_variance[d].first += value;
+                lb->_stats.add(varblock_t::VARIANCE, d, false, value);
                 _data[d]._lmid += f_var[d];
             } else {
-                lb->_variance[d].second += value;
+                lb->_stats.add(varblock_t::VARIANCE, d, true, value);
                 _data[d]._hmid += f_var[d];
             }
         }
     }
 
-    void MLearning::node_t::update(size_t id, bool minimize, const std::vector<MLearning>& clouds, std::vector<node_t>& nodes, size_t dimen, bool allowSplit, const double delta, const propts_t& options) {
+    void MLearning::node_t::update(size_t id, size_t label, bool minimize, const std::vector<MLearning>& clouds, std::pmr::vector<node_t>& nodes, size_t dimen, bool allowSplit, const double delta, const propts_t& options) {
+        PRLEARN_TRACE_SPAN("MLearning::update");
         assert(std::is_sorted(_samples.begin(), _samples.end()));
         assert(id < nodes.size());
         // Bellman update, compute "optimal" futures
         {
             auto tmpq = std::make_unique < std::pair<qvar_t, qvar_t>[]>(dimen);
-            auto tmp = aggregate_samples(clouds, dimen, minimize, tmpq.get(), options._discount);
+            auto tmp = aggregate_samples(clouds, dimen, minimize, tmpq.get(), options);
             tmp.second.cnt() = tmp.second.cnt() / 2.0;
             if (tmp.second.cnt() > tmp.first.cnt()) {
                 tmp.second.cnt() -= tmp.first.cnt();
@@ -437,8 +744,8 @@ namespace prlearn {
             } else if (tmp.second.cnt() > 0 && tmp.second.cnt() <= tmp.first.cnt()) {
                 // clear out old
                 for (int i = _samples.size() - 1; i >= 0; --i) {
-                    _samples[i]._old = nullptr;
-                    if (_samples[i]._variance == nullptr)
+                    _samples[i]._stats.clear(varblock_t::OLD);
+                    if (!_samples[i]._stats.has(varblock_t::VARIANCE))
                         _samples.erase(_samples.begin() + i);
                 }
             }
@@ -448,9 +755,10 @@ namespace prlearn {
             size_t svar = std::numeric_limits<size_t>::max();
             size_t cnt = 0;
             if (allowSplit) {
+                PRLEARN_TRACE_SPAN("MLearning::split_test");
                 if (_data == nullptr)
-                    _data = std::make_unique < data_t[]>(dimen);
-                for (size_t i = 0; i < dimen; ++i) {
+                    _data = make_pmr_array<data_t>(dimen);
+                for_each_dimension(dimen, dimen, options, [&](size_t i) {
                     _data[i]._splitfilter.add(tmpq[i].first,
                             tmpq[i].second,
                             delta * options._indefference,
@@ -458,6 +766,9 @@ namespace prlearn {
                             options._upper_t,
                             options._ks_limit,
                             options._filter_rate);
+                });
+                // pick the candidate in order of dimensions, independent of threads
+                for (size_t i = 0; i < dimen; ++i) {
                     if (_data[i]._splitfilter.max() >= options._filter_val) {
                         ++cnt;
                         if ((std::rand() % cnt) == 0)
@@ -481,53 +792,60 @@ namespace prlearn {
                         tmp += _data[i]._hmid;
                         if (tmp._avg != _data[i]._mid._avg) {
                             tmp += _data[i]._mid;
+                            if (options._split_log != nullptr) {
+                                split_event_t event;
+                                event._kind = split_event_t::REZERO;
+                                event._label = label;
+                                event._node = id;
+                                event._parent = _parent;
+                                event._dimension = i;
+                                event._boundary = tmp._avg;
+                                event._previous = _data[i]._mid._avg;
+                                event._low_count = _data[i]._lmid._cnt;
+                                event._high_count = _data[i]._hmid._cnt;
+                                options._split_log->record(event);
+                            }
                             _data[i] = data_t(); // clear old, set new mid, continue
                             _data[i]._mid = tmp;
                             for (auto& s : _samples) {
-                                if (s._variance) {
-                                    s._variance[i].first.cnt() = 0;
-                                    s._variance[i].second.cnt() = 0;
-                                    bool ok = false;
-                                    for (size_t j = 0; j < dimen; ++j) {
-                                        if (s._variance[j].first.cnt() != 0 ||
-                                                s._variance[j].second.cnt() != 0)
-                                            ok = true;
-                                    }
-                                    if (!ok)
-                                        s._variance = nullptr;
-                                }
-                                if (s._old) {
-                                    s._old[i].first.cnt() = 0;
-                                    s._old[i].second.cnt() = 0;
-                                    bool ok = false;
-                                    for (size_t j = 0; j < dimen; ++j) {
-                                        if (s._old[j].first.cnt() != 0 ||
-                                                s._old[j].second.cnt() != 0)
-                                            ok = true;
-                                    }
-                                    if (!ok)
-                                        s._old = nullptr;
-                                }
+                                s._stats.clear(varblock_t::VARIANCE, i);
+                                s._stats.clear(varblock_t::OLD, i);
                             }
                         }
                     }
                 }
                 for (int i = _samples.size() - 1; i >= 0; --i) {
-                    if (_samples[i]._variance == nullptr && _samples[i]._old == nullptr)
+                    if (!_samples[i]._stats.has(varblock_t::VARIANCE) && !_samples[i]._stats.has(varblock_t::OLD))
                         _samples.erase(_samples.begin() + i);
                 }
             }
             else if (cnt > 0) {
                 // SPLIT!
+                PRLEARN_TRACE_SPAN("MLearning::split");
                 _split._is_split = true;
                 _split._var = svar; //sv.first;
                 _split._boundary = _data[svar]._mid._avg;
                 assert(!std::isnan(_split._boundary));
                 auto slow = _split._low = nodes.size();
                 auto shigh = _split._high = nodes.size() + 1;
-                std::vector<interesect_t> samples;
+                if (options._split_log != nullptr) {
+                    auto& f = _data[svar]._splitfilter;
+                    split_event_t event;
+                    event._filter = split_event_t::trigger(f._vfilter, f._hfilter, f._lfilter);
+                    event._label = label;
+                    event._node = id;
+                    event._parent = _parent;
+                    event._low = slow;
+                    event._high = shigh;
+                    event._dimension = svar;
+                    event._boundary = _split._boundary;
+                    event._low_count = _data[svar]._lmid._cnt;
+                    event._high_count = _data[svar]._hmid._cnt;
+                    options._split_log->record(event);
+                }
+                std::pmr::vector<interesect_t> samples(_samples.get_allocator());
                 _samples.swap(samples);
-                std::unique_ptr < data_t[] > data;
+                pmr_array_t<data_t> data;
                 data.swap(_data);
                 // this  <-- is invalidated below invalid!
                 nodes.emplace_back();
@@ -539,8 +857,8 @@ namespace prlearn {
                 nodes[shigh]._old = tmpq[svar].second;
                 nodes[slow]._parent = id;
                 nodes[shigh]._parent = id;
-                nodes[slow]._data = std::make_unique < data_t[]>(dimen);
-                nodes[shigh]._data = std::make_unique < data_t[]>(dimen);
+                nodes[slow]._data = make_pmr_array<data_t>(dimen);
+                nodes[shigh]._data = make_pmr_array<data_t>(dimen);
                 for (size_t i = 0; i < dimen; ++i) {
                     if (i == svar) {
                         nodes[slow]._data[i]._mid = data[i]._lmid;
@@ -554,46 +872,180 @@ namespace prlearn {
                     }
                 }
 
-                // copy over samples here!
+                // move samples over, only copy those which go to both children
                 for (auto& s : samples) {
 
-                    if (s._variance != nullptr) {
-                        double frac = s._variance[svar].second.cnt();
-                        if (s._variance[svar].first.cnt() + s._variance[svar].second.cnt() == 0)
+                    if (s._stats.has(varblock_t::VARIANCE)) {
+                        auto lowq = s._stats.get(varblock_t::VARIANCE, svar, false);
+                        auto highq = s._stats.get(varblock_t::VARIANCE, svar, true);
+                        if (lowq.cnt() + highq.cnt() == 0)
                             continue;
-                        frac /= (double) (s._variance[svar].first.cnt() + s._variance[svar].second.cnt());
+                        double frac = lowq.cnt() / (double) (lowq.cnt() + highq.cnt());
                         assert(frac <= 1);
-                        for (auto n :{slow, shigh}) {
-                            frac = 1.0 - frac;
-                            if (n == slow && s._variance[svar].first.cnt() == 0)
-                                continue;
-                            if (n == shigh && s._variance[svar].second.cnt() == 0)
-                                continue;
-                            nodes[n]._samples.emplace_back(s, dimen);
-                            auto& ns = nodes[n]._samples.back();
-                            auto& nsv = ns._variance;
-                            if (n == slow)
-                                nsv[svar].second = nsv[svar].first;
-                            else
-                                nsv[svar].first = nsv[svar].second;
-                            nsv[svar].first.cnt() = nsv[svar].second.cnt() = nsv[svar].first.cnt() / 2.0;
-                            for (size_t i = 0; i < dimen; ++i) {
-                                if (i == svar) continue;
-                                nsv[i].first.cnt() = frac * nsv[i].first.cnt();
-                                nsv[i].second.cnt() = frac * nsv[i].second.cnt();
-                            }
-                            ns._old.swap(ns._variance);
-                            ns._variance = nullptr;
-                            assert(std::is_sorted(nodes[n]._samples.begin(), nodes[n]._samples.end()));
+                        if (lowq.cnt() != 0 && highq.cnt() != 0) {
+                            nodes[slow]._samples.emplace_back(s);
+                            nodes[slow]._samples.back().split(svar, lowq, frac, options._split_decay);
+                        }
+                        if (highq.cnt() != 0) {
+                            nodes[shigh]._samples.emplace_back(std::move(s));
+                            nodes[shigh]._samples.back().split(svar, highq, 1.0 - frac, options._split_decay);
+                        } else {
+                            nodes[slow]._samples.emplace_back(std::move(s));
+                            nodes[slow]._samples.back().split(svar, lowq, frac, options._split_decay);
                         }
                     }
                 }
+                assert(std::is_sorted(nodes[slow]._samples.begin(), nodes[slow]._samples.end()));
+                assert(std::is_sorted(nodes[shigh]._samples.begin(), nodes[shigh]._samples.end()));
                 nodes[id].update_parents(nodes, id, minimize);
             }
         }
     }
 
-    size_t MLearning::node_t::find_node(const std::vector<node_t>& nodes, const double* point, const size_t id) const {
+    void MLearning::write(std::ostream& s) const {
+        uint64_t sizes[3] = {_dimen, _mapping.size(), _nodes.size()};
+        write_binary(s, sizes, 3);
+        for (auto& el : _mapping) {
+            write_binary(s, &el._label);
+            write_binary(s, &el._nid);
+        }
+        for (auto& n : _nodes)
+            n.write(s, _dimen);
+    }
+
+    bool MLearning::read(std::istream& s, uint32_t version) {
+        // the layout has not changed since version 1
+        if (version < 1 || version > checkpoint_version)
+            return false;
+        memory::scope_t scope(_nodes.get_allocator().resource());
+        uint64_t sizes[3];
+        // see varblock_t::init for the bound of the dimension
+        if (!read_binary(s, sizes, 3) || sizes[0] >= ((uint64_t) 1 << 31)) return false;
+        _dimen = sizes[0];
+        // grown while read; the sizes are not trusted for allocation
+        _mapping.clear();
+        for (uint64_t i = 0; i < sizes[1]; ++i) {
+            el_t el(0);
+            if (!read_binary(s, &el._label) || !read_binary(s, &el._nid) || el._nid >= sizes[2])
+                return false;
+            _mapping.push_back(el);
+        }
+        _nodes.clear();
+        for (uint64_t i = 0; i < sizes[2]; ++i) {
+            _nodes.emplace_back();
+            if (!_nodes.back().read(s, i, _dimen, sizes[2]))
+                return false;
+        }
+        // the labels start in roots, and parents and children agree; with
+        // children after their parent (see node_t::read) this is a forest.
+        for (auto& el : _mapping) {
+            if (_nodes[el._nid]._parent != el._nid)
+                return false;
+        }
+        for (size_t i = 0; i < _nodes.size(); ++i) {
+            auto& split = _nodes[i]._split;
+            if (split._is_split && (_nodes[split._low]._parent != i || _nodes[split._high]._parent != i))
+                return false;
+            auto& parent = _nodes[_nodes[i]._parent];
+            if (_nodes[i]._parent != i && (!parent._split._is_split ||
+                    (parent._split._low != i && parent._split._high != i)))
+                return false;
+        }
+        return true;
+    }
+
+    bool MLearning::valid(const std::vector<MLearning>& clouds) const {
+        for (auto& n : _nodes) {
+            for (auto& sample : n._samples) {
+                if (sample._cloud >= clouds.size())
+                    return false;
+                auto& cloud = clouds[sample._cloud];
+                if (sample._size > cloud._mapping.size())
+                    return false;
+                for (size_t i = 0; i < sample._size; ++i) {
+                    if (sample._nodes[i] >= cloud._nodes.size())
+                        return false;
+                }
+            }
+        }
+        return true;
+    }
+
+    void MLearning::node_t::write(std::ostream& s, size_t dimen) const {
+        _split.write(s);
+        _q.write(s);
+        _old.write(s);
+        write_binary(s, &_parent);
+        uint64_t n = _samples.size();
+        write_binary(s, &n);
+        for (auto& sample : _samples) {
+            write_binary(s, &sample._size);
+            write_binary(s, &sample._cloud);
+            write_binary(s, sample._nodes.get(), sample._size);
+            sample._stats.write(s);
+        }
+        bool data = _data != nullptr;
+        write_binary(s, &data);
+        for (size_t i = 0; data && i < dimen; ++i) {
+            _data[i]._lmid.write(s);
+            _data[i]._hmid.write(s);
+            _data[i]._mid.write(s);
+            _data[i]._splitfilter.write(s);
+        }
+    }
+
+    bool MLearning::node_t::read(std::istream& s, size_t id, size_t dimen, size_t n_nodes) {
+        uint64_t n;
+        if (!_split.read(s) || !_q.read(s) || !_old.read(s) ||
+                !read_binary(s, &_parent) || !read_binary(s, &n))
+            return false;
+        // children are always added after their parent
+        if (_parent >= n_nodes || (_split._is_split && (_split._var >= dimen || _split._low == _split._high ||
+                _split._low <= id || _split._high <= id || _split._low >= n_nodes || _split._high >= n_nodes)))
+            return false;
+        _samples.clear();
+        for (size_t i = 0; i < n; ++i) {
+            interesect_t sample;
+            if (!read_binary(s, &sample._size) || !read_binary(s, &sample._cloud))
+                return false;
+            if (sample._size > 0) {
+                // in chunks, so a corrupt size fails at the end of the
+                // stream instead of asking for the memory up front
+                std::vector<size_t> ids;
+                for (size_t done = 0; done < sample._size;) {
+                    auto chunk = std::min<size_t>(sample._size - done, 1024);
+                    ids.resize(done + chunk);
+                    if (!read_binary(s, ids.data() + done, chunk))
+                        return false;
+                    done += chunk;
+                }
+                auto nodes = make_pmr_array<size_t>(sample._size);
+                std::copy(ids.begin(), ids.end(), nodes.get());
+                sample._nodes = share_pmr_array(std::move(nodes));
+            }
+            if (!sample._stats.read(s, dimen))
+                return false;
+            // sorted and unique, see add_sample
+            if (!_samples.empty() && !(_samples.back() < sample))
+                return false;
+            _samples.emplace_back(std::move(sample));
+        }
+        uint8_t data; // written as a bool
+        if (!read_binary(s, &data) || data > 1)
+            return false;
+        _data = nullptr;
+        if (data == 1) {
+            _data = make_pmr_array<data_t>(dimen);
+            for (size_t i = 0; i < dimen; ++i) {
+                if (!_data[i]._lmid.read(s) || !_data[i]._hmid.read(s) ||
+                        !_data[i]._mid.read(s) || !_data[i]._splitfilter.read(s))
+                    return false;
+            }
+        }
+        return true;
+    }
+
+    size_t MLearning::node_t::find_node(const std::pmr::vector<node_t>& nodes, const double* point, const size_t id) const {
         if (_split._is_split) {
             auto next = point[_split._var] <= _split._boundary ? _split._low : _split._high;
             return nodes[next].find_node(nodes, point, next);
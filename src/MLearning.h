@@ -31,6 +31,7 @@
 
 #include <map>
 #include <limits>
+#include <cstdint>
 
 namespace prlearn {
 
@@ -57,23 +58,128 @@ namespace prlearn {
 
         qvar_t lookup(size_t label, const double* f_var, size_t dimen) const;
 
+        // number of tree-nodes, for statistics
+        size_t size() const {
+            return _nodes.size();
+        }
+
+        // of the samples so far, 0 before the first
+        size_t dimen() const {
+            return _dimen;
+        }
+
+        // the labels sampled so far, sorted
+        std::vector<size_t> labels() const;
+
         void print(std::ostream& s, size_t tabs, std::map<size_t, size_t>& edge_map, const std::vector<MLearning>& clouds) const;
 
+        // complete training state, see checkpoint.h
+        void write(std::ostream& s) const;
+        bool read(std::istream& s, uint32_t version);
+        // the references into the other clouds, after read
+        bool valid(const std::vector<MLearning>& clouds) const;
+        static constexpr uint32_t checkpoint_tag = 1;
+        static constexpr uint32_t checkpoint_version = 2;
+
     protected:
 
-        std::unique_ptr<size_t[] > findIntersection(const double* point) const;
+        pmr_array_t<size_t> findIntersection(const double* point) const;
+        void findRegion(const size_t* nodes, size_t n, double* lower, double* upper) const;
+        size_t findContainer(size_t root, const double* lower, const double* upper) const;
+
+        // Compact storage of the (low, high) statistics of a future for
+        // each dimension. Both the current statistics and the ones carried
+        // over from before a split (old) live in a single allocation;
+        // a header, a presence-bitmap per kind and packed float-triples
+        // for only those halves which have a non-zero count.
+        class varblock_t {
+        public:
+            enum kind_t {
+                VARIANCE = 0, OLD = 1
+            };
+
+            varblock_t() = default;
+            varblock_t(const varblock_t& other);
+            varblock_t(varblock_t&&) = default;
+            varblock_t& operator=(varblock_t&&) = default;
+
+            void init(size_t dimen);
+            bool has(kind_t kind) const;
+            qvar_t get(kind_t kind, size_t dim, bool high) const;
+            void set(kind_t kind, size_t dim, bool high, const qvar_t& value);
+            void add(kind_t kind, size_t dim, bool high, double value);
+            void clear(kind_t kind);
+            void clear(kind_t kind, size_t dim);
+            void make_old();
+            void write(std::ostream& s) const;
+            bool read(std::istream& s, size_t dimen);
+
+            template<typename F>
+            void transform(kind_t kind, F&& fun) {
+                if (!has(kind)) return;
+                const uint64_t* bm = bitmap(kind);
+                float* e = entries() + 3 * offset(kind);
+                for (size_t w = 0; w < bitmap_words(dimen()); ++w) {
+                    for (uint64_t bits = bm[w]; bits != 0; bits &= bits - 1) {
+                        size_t bit = w * 64 + lowest(bits);
+                        qvar_t v(e[0], e[1], e[2]);
+                        fun(bit / 2, (bit % 2) == 1, v);
+                        e[0] = v.avg();
+                        e[1] = v.cnt();
+                        e[2] = v._variance;
+                        e += 3;
+                    }
+                }
+            }
+
+            template<typename F>
+            void for_each(kind_t kind, F&& fun) const {
+                if (!has(kind)) return;
+                const uint64_t* bm = bitmap(kind);
+                const float* e = entries() + 3 * offset(kind);
+                for (size_t w = 0; w < bitmap_words(dimen()); ++w) {
+                    for (uint64_t bits = bm[w]; bits != 0; bits &= bits - 1) {
+                        size_t bit = w * 64 + lowest(bits);
+                        fun(bit / 2, (bit % 2) == 1, qvar_t(e[0], e[1], e[2]));
+                        e += 3;
+                    }
+                }
+            }
+
+        private:
+            // word 0: dimen | capacity << 32, word 1: variance-size | old-size << 32
+            pmr_array_t<uint64_t> _block = nullptr;
+
+            static size_t bitmap_words(size_t dimen) {
+                return (2 * dimen + 63) / 64;
+            }
+            static size_t lowest(uint64_t bits);
+            size_t dimen() const;
+            size_t capacity() const;
+            size_t size(kind_t kind) const;
+            size_t offset(kind_t kind) const;
+            size_t rank(kind_t kind, size_t bit) const;
+            void resize(kind_t kind, size_t size);
+            void reserve(size_t cap);
+            const uint64_t* bitmap(kind_t kind) const;
+            uint64_t* bitmap(kind_t kind);
+            const float* entries() const;
+            float* entries();
+        };
 
         struct interesect_t {
             size_t _size = 0;
             size_t _cloud = std::numeric_limits<size_t>::max();
-            std::unique_ptr<size_t[] > _nodes = nullptr;
-            std::unique_ptr<std::pair<qvar_t, qvar_t>[] > _variance = nullptr;
-            std::unique_ptr<std::pair<qvar_t, qvar_t>[] > _old = nullptr;
+            // never modified once set, so copies within a learner share it;
+            // a copy of the learner gets its own, see node_t(node_t, dimen)
+            std::shared_ptr<const size_t[] > _nodes = nullptr;
+            varblock_t _stats;
 
             interesect_t() = default;
             interesect_t(interesect_t&&) = default;
             interesect_t& operator=(interesect_t&&) = default;
-            interesect_t(const interesect_t& other, size_t dimen);
+            interesect_t(const interesect_t& other) = default;
+            void split(size_t svar, qvar_t sv, double frac, double decay);
             bool operator<(const interesect_t& other) const;
             bool operator!=(const interesect_t& other) const;
         };
@@ -88,25 +194,28 @@ namespace prlearn {
             qvar_t _q;
             qvar_t _old;
             size_t _parent;
-            std::vector<interesect_t> _samples;
-            std::unique_ptr<data_t[] > _data = nullptr;
+            std::pmr::vector<interesect_t> _samples{memory::current()};
+            pmr_array_t<data_t> _data = nullptr;
             node_t() = default;
             node_t(const node_t& other, size_t dimen);
             node_t(node_t&& other) noexcept = default;
             node_t& operator=(node_t&& other) noexcept = default;
 
-            size_t find_node(const std::vector<node_t>& nodes, const double * point, const size_t id) const;
-            void update(size_t id, bool minimize, const std::vector<MLearning>& clouds, std::vector<node_t>& nodes, size_t dimen, bool allowSplit, const double delta, const propts_t& options);
-            std::pair<qvar_t, qvar_t> aggregate_samples(const std::vector<MLearning>& clouds, size_t dimen, bool minimize, std::pair<qvar_t, qvar_t>* tmpq, double discount);
-            void print(std::ostream& s, size_t tabs, const std::vector<node_t>& nodes) const;
+            size_t find_node(const std::pmr::vector<node_t>& nodes, const double * point, const size_t id) const;
+            void write(std::ostream& s, size_t dimen) const;
+            bool read(std::istream& s, size_t id, size_t dimen, size_t n_nodes);
+            void update(size_t id, size_t label, bool minimize, const std::vector<MLearning>& clouds, std::pmr::vector<node_t>& nodes, size_t dimen, bool allowSplit, const double delta, const propts_t& options);
+            std::pair<qvar_t, qvar_t> aggregate_samples(const std::vector<MLearning>& clouds, size_t dimen, bool minimize, std::pair<qvar_t, qvar_t>* tmpq, const propts_t& options);
+            void print(std::ostream& s, size_t tabs, const std::pmr::vector<node_t>& nodes) const;
             void tighten_samples(const std::vector<MLearning>& clouds, size_t cloud);
             void add_sample(size_t dest, const double* f_var, const double* point, double value, size_t dimen, const std::vector<MLearning>& clouds);
-            static void update_parents(std::vector<node_t>& nodes, size_t next, bool minimize);
+            static void update_parents(std::pmr::vector<node_t>& nodes, size_t next, bool minimize);
         };
 
         size_t _dimen = 0;
-        std::vector<el_t> _mapping;
-        std::vector<node_t> _nodes;
+        // in the resource current at construction, see pmr.h
+        std::pmr::vector<el_t> _mapping{memory::current()};
+        std::pmr::vector<node_t> _nodes{memory::current()};
     };
 }
 #endif /* MLEARNING_H */
@@ -25,6 +25,7 @@
 #ifndef QLEARNING_H
 #define QLEARNING_H
 #include "structs.h"
+#include "trace.h"
 
 #include <vector>
 #include <utility>
@@ -61,6 +62,11 @@ namespace prlearn {
             return res;
         }
 
+        // size of the regressor, for statistics
+        size_t size() const {
+            return _regressor.size();
+        }
+
     protected:
         Regressor _regressor;
     };
@@ -72,11 +78,14 @@ namespace prlearn {
             size_t label, size_t dest, double value, // cost
             const std::vector<QLearning<Regressor>>&clouds, // other points
             bool minimization, const double delta, const propts_t& options) {
+        PRLEARN_TRACE_SPAN("QLearning::addSample");
         // The ALPHA part of Q-learning is handled inside the regressors
         auto toDone = 0.0;
 
-        if (dest != 0 && options._discount != 0)
+        if (dest != 0 && options._discount != 0) {
+            PRLEARN_TRACE_SPAN("QLearning::getBestQ");
             toDone = clouds[dest]._regressor.getBestQ(t_var, minimization, next_labels, n_labels); // 0 is a special sink-node.
+        }
         auto nval = value;
         // if future is not a weird number, then add it (discounted)
         if (!std::isinf(toDone) && !std::isnan(toDone)) {
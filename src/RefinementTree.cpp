@@ -24,6 +24,8 @@
 
 
 #include "RefinementTree.h"
+#include "trace.h"
+#include "splitlog.h"
 #include <limits>
 #include <iomanip>
 
@@ -108,6 +110,8 @@ namespace prlearn {
 
     void
     RefinementTree::update(size_t label, const double* point, size_t dimen, double nval, const double delta, const propts_t& options) {
+        PRLEARN_TRACE_SPAN("RefinementTree::update");
+        memory::scope_t scope(_nodes.get_allocator().resource());
         _dimen = dimen;
         el_t lf(label);
         auto res = std::lower_bound(std::begin(_mapping), std::end(_mapping), lf);
@@ -118,8 +122,21 @@ namespace prlearn {
         }
 
         assert(res->_label == label);
-        auto n = _nodes[res->_nid].get_leaf(point, res->_nid, _nodes);
-        _nodes[n].update(point, dimen, nval, _nodes, delta, options);
+        size_t n;
+        {
+            PRLEARN_TRACE_SPAN("RefinementTree::descent");
+            n = _nodes[res->_nid].get_leaf(point, res->_nid, _nodes);
+        }
+        // nodes do not know their parent; only needed for the split-log
+        auto parent = res->_nid;
+        if (options._split_log != nullptr) {
+            for (auto p = res->_nid; p != n;) {
+                parent = p;
+                auto& split = _nodes[p]._split;
+                p = point[split._var] <= split._boundary ? split._low : split._high;
+            }
+        }
+        _nodes[n].update(point, dimen, nval, _nodes, delta, options, label, parent);
     }
 
     RefinementTree::node_t::node_t(const node_t& other, size_t dimen) {
@@ -127,7 +144,7 @@ namespace prlearn {
         _split = other._split;
     }
 
-    void RefinementTree::node_t::print(std::ostream& s, size_t tabs, const std::vector<node_t>& nodes) const {
+    void RefinementTree::node_t::print(std::ostream& s, size_t tabs, const std::pmr::vector<node_t>& nodes) const {
         for (size_t i = 0; i < tabs; ++i) s << "\t";
         if (_split._is_split) {
             s << "{\"var\":" << _split._var << ",\"bound\":" << _split._boundary << ",\n";
@@ -150,7 +167,7 @@ namespace prlearn {
         }
     }
 
-    size_t RefinementTree::node_t::get_leaf(const double* point, size_t current, const std::vector<node_t>& nodes) const {
+    size_t RefinementTree::node_t::get_leaf(const double* point, size_t current, const std::pmr::vector<node_t>& nodes) const {
         if (!_split._is_split) return current;
         if (point[_split._var] <= _split._boundary)
             return nodes[_split._low].get_leaf(point, _split._low, nodes);
@@ -158,10 +175,12 @@ namespace prlearn {
             return nodes[_split._high].get_leaf(point, _split._high, nodes);
     }
 
-    void RefinementTree::node_t::update(const double* point, size_t dimen, double nval, std::vector<node_t>& nodes, double delta, const propts_t& options) {
+    void RefinementTree::node_t::update(const double* point, size_t dimen, double nval, std::pmr::vector<node_t>& nodes, double delta, const propts_t& options, size_t label, size_t parent) {
         assert(!_split._is_split);
-        if (_predictor._data == nullptr)
-            _predictor._data = std::make_unique < qdata_t[]>(dimen);
+        if (_predictor._data == nullptr) {
+            _predictor._data = make_pmr_array<qdata_t>(dimen);
+            _predictor._qs = qvar_array_t(2 * dimen);
+        }
 
         // let us start by enforcing the learning-rate
         _predictor._q.cnt() = std::min<size_t>(_predictor._q.cnt(), options._q_learn_rate);
@@ -170,52 +189,81 @@ namespace prlearn {
         auto svar = 0;
         auto cnt = 0;
 
+        // add new data-point to all hypothetical new partitions; the Q-values
+        // are done in one bulk-update, selecting low or high by weight.
+        static thread_local std::vector<double> side;
+        side.resize(2 * dimen);
         for (size_t i = 0; i < dimen; ++i) {
-            // add new data-point to all hypothetical new partitions
             if (point[i] <= _predictor._data[i]._midpoint._avg) {
-                _predictor._data[i]._lowq += nval;
+                side[i] = 1;
                 _predictor._data[i]._lmid += point[i];
             } else {
-                _predictor._data[i]._highq += nval;
+                side[i] = 0;
                 _predictor._data[i]._hmid += point[i];
             }
+            side[dimen + i] = 1 - side[i];
+        }
+        _predictor._qs.add(nval, side.data());
 
-            // update the split-filters
-            _predictor._data[i]._splitfilter.add(_predictor._data[i]._lowq,
-                    _predictor._data[i]._highq,
-                    delta * options._indefference,
-                    options._lower_t,
-                    options._upper_t,
-                    options._ks_limit,
-                    options._filter_rate);
+        {
+            PRLEARN_TRACE_SPAN("RefinementTree::split_test");
+            for (size_t i = 0; i < dimen; ++i) {
+                // update the split-filters
+                _predictor._data[i]._splitfilter.add(_predictor._qs.get(i),
+                        _predictor._qs.get(dimen + i),
+                        delta * options._indefference,
+                        options._lower_t,
+                        options._upper_t,
+                        options._ks_limit,
+                        options._filter_rate);
 
-            // if the critical value is reached by any of the three split-conditions,
-            // we split. Notice the random choice - we want to avoid bias.
-            if (_predictor._data[i]._splitfilter.max() >= options._filter_val) {
-                ++cnt;
-                if ((std::rand() % cnt) == 0)
-                    svar = i;
+                // if the critical value is reached by any of the three split-conditions,
+                // we split. Notice the random choice - we want to avoid bias.
+                if (_predictor._data[i]._splitfilter.max() >= options._filter_val) {
+                    ++cnt;
+                    if ((std::rand() % cnt) == 0)
+                        svar = i;
+                }
             }
         }
 
         // only true if some candidate exceeded the critical value.
         if (cnt > 0) {
+            PRLEARN_TRACE_SPAN("RefinementTree::split");
             _split._is_split = true;
             _split._var = svar;
             _split._boundary = _predictor._data[svar]._midpoint._avg;
             auto slow = _split._low = nodes.size();
             auto shigh = _split._high = nodes.size() + 1;
-            std::unique_ptr < qdata_t[] > tmp;
+            if (options._split_log != nullptr) {
+                auto& f = _predictor._data[svar]._splitfilter;
+                split_event_t event;
+                event._filter = split_event_t::trigger(f._vfilter, f._hfilter, f._lfilter);
+                event._label = label;
+                event._node = this - nodes.data();
+                event._parent = parent;
+                event._low = slow;
+                event._high = shigh;
+                event._dimension = svar;
+                event._boundary = _split._boundary;
+                event._low_count = _predictor._data[svar]._lmid._cnt;
+                event._high_count = _predictor._data[svar]._hmid._cnt;
+                options._split_log->record(event);
+            }
+            pmr_array_t<qdata_t> tmp;
             tmp.swap(_predictor._data);
+            auto qs = std::move(_predictor._qs);
             auto oq = _predictor._q;
 
             // this  <-- is invalidated below!
             nodes.emplace_back();
             nodes.emplace_back();
-            nodes[slow]._predictor._q = tmp[svar]._lowq;
-            nodes[shigh]._predictor._q = tmp[svar]._highq;
-            nodes[slow]._predictor._data = std::make_unique < qdata_t[]>(dimen);
-            nodes[shigh]._predictor._data = std::make_unique < qdata_t[]>(dimen);
+            nodes[slow]._predictor._q = qs.get(svar);
+            nodes[shigh]._predictor._q = qs.get(dimen + svar);
+            nodes[slow]._predictor._data = make_pmr_array<qdata_t>(dimen);
+            nodes[shigh]._predictor._data = make_pmr_array<qdata_t>(dimen);
+            nodes[slow]._predictor._qs = qvar_array_t(2 * dimen);
+            nodes[shigh]._predictor._qs = qvar_array_t(2 * dimen);
             for (int i = 0; i < (int) dimen; ++i) {
                 if (i == svar) {
                     nodes[slow]._predictor._data[i]._midpoint = tmp[i]._lmid;
@@ -260,6 +308,21 @@ namespace prlearn {
                             continue;
 
                         rezero = true;
+                        if (options._split_log != nullptr) {
+                            split_event_t event;
+                            event._kind = split_event_t::REZERO;
+                            event._label = label;
+                            event._node = this - nodes.data();
+                            event._parent = parent;
+                            event._dimension = i;
+                            event._previous = dp._midpoint._avg;
+                            event._low_count = dp._lmid._cnt;
+                            event._high_count = dp._hmid._cnt;
+                            auto nmid = dp._midpoint;
+                            nmid += nm;
+                            event._boundary = nmid._avg;
+                            options._split_log->record(event);
+                        }
                         dp._hmid = nm;
                         dp._lmid = nm;
                         dp._hmid._cnt /= 2;
@@ -267,9 +330,10 @@ namespace prlearn {
                         dp._midpoint += nm;
 
                         // merge Q-values. TODO: See if this cannot be done better.
-                        dp._lowq = qvar_t::approximate(dp._lowq, dp._highq);
-                        dp._lowq.cnt() /= 2;
-                        dp._highq = dp._lowq;
+                        auto nq = qvar_t::approximate(_predictor._qs.get(i), _predictor._qs.get(dimen + i));
+                        nq.cnt() /= 2;
+                        _predictor._qs.set(i, nq);
+                        _predictor._qs.set(dimen + i, nq);
                     }
                 }
                 // If any was reset, reset all split-counters.
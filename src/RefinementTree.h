@@ -44,6 +44,11 @@ namespace prlearn {
 
         qvar_t lookup(size_t label, const double*, size_t dimen) const;
 
+        // number of tree-nodes, for statistics
+        size_t size() const {
+            return _nodes.size();
+        }
+
         void update(size_t label, const double*, size_t dimen, double nval, const double delta, const propts_t& options);
 
         void print(std::ostream& s, size_t tabs, std::map<size_t, size_t>& edge_map) const;
@@ -55,7 +60,6 @@ namespace prlearn {
         struct qdata_t {
             avg_t _midpoint;
             avg_t _lmid, _hmid;
-            qvar_t _lowq, _highq;
             splitfilter_t _splitfilter;
         };
 
@@ -66,15 +70,18 @@ namespace prlearn {
 
             qpred_t(const qpred_t& other, size_t dimen) {
                 _q = other._q;
+                _qs = other._qs;
                 if (other._data) {
-                    _data = std::make_unique < qdata_t[]>(dimen);
+                    _data = make_pmr_array<qdata_t>(dimen);
                     for (size_t i = 0; i < dimen; ++i)
                         _data[i] = other._data[i];
                 }
             }
             qvar_t _q;
             size_t _cnt = 0;
-            std::unique_ptr<qdata_t[] > _data = nullptr;
+            pmr_array_t<qdata_t> _data = nullptr;
+            // Q of the hypothetical low (i) and high (dimen + i) partitions
+            qvar_array_t _qs;
         };
 
         struct node_t {
@@ -85,9 +92,9 @@ namespace prlearn {
             simple_split_t _split;
             qpred_t _predictor;
 
-            size_t get_leaf(const double* point, size_t current, const std::vector<node_t>& nodes) const;
-            void update(const double* point, size_t dimen, double nval, std::vector<node_t>& nodes, double delta, const propts_t& options);
-            void print(std::ostream& s, size_t tabs, const std::vector<node_t>& nodes) const;
+            size_t get_leaf(const double* point, size_t current, const std::pmr::vector<node_t>& nodes) const;
+            void update(const double* point, size_t dimen, double nval, std::pmr::vector<node_t>& nodes, double delta, const propts_t& options, size_t label, size_t parent);
+            void print(std::ostream& s, size_t tabs, const std::pmr::vector<node_t>& nodes) const;
 
             node_t() = default;
             node_t(const node_t& other, size_t dimen);
@@ -95,8 +102,9 @@ namespace prlearn {
             node_t& operator=(node_t&& other) noexcept = default;
         };
 
-        std::vector<el_t> _mapping;
-        std::vector<node_t> _nodes;
+        // in the resource current at construction, see pmr.h
+        std::pmr::vector<el_t> _mapping{memory::current()};
+        std::pmr::vector<node_t> _nodes{memory::current()};
         size_t _dimen = 0;
     };
 
@@ -0,0 +1,150 @@
+/*
+ * Copyright Peter G. Jensen
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * File:   SimpleMGraph.cpp
+ * Author: Peter G. Jensen
+ *
+ * Created on October 17, 2026, 3:05 PM
+ */
+
+#include "SimpleMGraph.h"
+#include "threadpool.h"
+
+#include <algorithm>
+
+namespace prlearn {
+
+    SimpleMGraph::SimpleMGraph(const std::vector<SimpleMLearning>& clouds) {
+        size_t n_actions = 0;
+        size_t n_succs = 0;
+        for (auto& c : clouds) {
+            n_actions += c._nodes.size();
+            for (auto& n : c._nodes)
+                n_succs += n._succssors.size();
+        }
+        _cloud_offset.reserve(clouds.size() + 1);
+        _action_offset.reserve(n_actions + 1);
+        _cost.reserve(n_actions);
+        _succ.reserve(n_succs);
+        _prob.reserve(n_succs);
+        _values.reserve(clouds.size());
+
+        _cloud_offset.push_back(0);
+        _action_offset.push_back(0);
+        for (auto& c : clouds) {
+            for (auto& n : c._nodes) {
+                double cnt = 0;
+                for (auto& s : n._succssors)
+                    cnt += s._cost.cnt();
+                double cost = 0;
+                // without recorded successors the action is terminal, with
+                // value 0 as in SimpleMLearning::node_t::update
+                for (auto& s : n._succssors) {
+                    if (cnt <= 0) break;
+                    auto p = s._cost.cnt() / cnt;
+                    cost += p * s._cost.avg();
+                    _succ.push_back(s._nid);
+                    _prob.push_back(p);
+                }
+                _cost.push_back(cost);
+                _action_offset.push_back(_succ.size());
+            }
+            _cloud_offset.push_back(_cost.size());
+            // successors without a (finite) value count as zero, see SimpleMLearning::update
+            auto v = c._q.avg();
+            _values.push_back(std::isinf(v) || std::isnan(v) ? 0 : v);
+        }
+        _q.assign(_cost.size(), 0);
+        _next = _values;
+    }
+
+    double SimpleMGraph::iterate(size_t cloud, bool minimization) {
+        const auto first = _cloud_offset[cloud];
+        const auto last = _cloud_offset[cloud + 1];
+        if (first == last)
+            return 0;
+        const double* values = _values.data();
+        auto best = minimization ? std::numeric_limits<double>::infinity() :
+                -std::numeric_limits<double>::infinity();
+        for (size_t a = first; a < last; ++a) {
+            const size_t* succ = _succ.data() + _action_offset[a];
+            const double* prob = _prob.data() + _action_offset[a];
+            const size_t n = _action_offset[a + 1] - _action_offset[a];
+            double q = 0;
+            for (size_t i = 0; i < n; ++i)
+                q += prob[i] * values[succ[i]];
+            q += _cost[a];
+            _q[a] = q;
+            best = minimization ? std::min(best, q) : std::max(best, q);
+        }
+        _next[cloud] = best;
+        return std::abs(best - _values[cloud]);
+    }
+
+    size_t SimpleMGraph::solve(bool minimization, double epsilon, size_t max_iterations, size_t threads) {
+        const size_t n = _values.size();
+        threadpool_t* pool = nullptr;
+        size_t chunks = 1;
+        if (threads > 1 && n > 1) {
+            pool = &threadpool_t::shared(threads);
+            chunks = std::min(n, std::min(threads, pool->size()) * 4);
+        }
+        const size_t width = (n + chunks - 1) / chunks;
+        std::vector<double> residual(chunks, 0);
+        auto sweep = [&](size_t c) {
+            double r = 0;
+            for (size_t i = c * width; i < std::min(n, (c + 1) * width); ++i)
+                r = std::max(r, iterate(i, minimization));
+            residual[c] = r;
+        };
+
+        size_t it = 0;
+        for (; it < max_iterations; ++it) {
+            if (pool)
+                pool->run(chunks, sweep);
+            else
+                sweep(0);
+            _values.swap(_next);
+            _residual = *std::max_element(residual.begin(), residual.end());
+            if (_residual <= epsilon) {
+                ++it;
+                break;
+            }
+        }
+        return it;
+    }
+
+    void SimpleMGraph::store(std::vector<SimpleMLearning>& clouds, bool minimization) const {
+        assert(clouds.size() + 1 == _cloud_offset.size());
+        for (size_t c = 0; c < clouds.size(); ++c) {
+            auto& cloud = clouds[c];
+            assert(cloud._nodes.size() == _cloud_offset[c + 1] - _cloud_offset[c]);
+            if (cloud._nodes.empty())
+                continue;
+            for (size_t a = 0; a < cloud._nodes.size(); ++a) {
+                auto& node = cloud._nodes[a];
+                avg_t nq;
+                nq._avg = _q[_cloud_offset[c] + a];
+                for (auto& s : node._succssors)
+                    nq._cnt += s._cost.cnt();
+                node.set_value(nq);
+            }
+            cloud.update_best(minimization);
+        }
+    }
+}
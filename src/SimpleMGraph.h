@@ -0,0 +1,76 @@
+/*
+ * Copyright Peter G. Jensen
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * File:   SimpleMGraph.h
+ * Author: Peter G. Jensen
+ *
+ * Created on October 17, 2026, 3:05 PM
+ */
+
+#ifndef SIMPLEMGRAPH_H
+#define SIMPLEMGRAPH_H
+
+#include "SimpleMLearning.h"
+
+#include <vector>
+
+namespace prlearn {
+
+    // The empirical model of a vector of SimpleMLearning clouds compiled
+    // into a single CSR graph; clouds -> actions -> successors. Costs are
+    // folded into one expected cost per action and the successor
+    // probabilities are taken from the sample counts, so a value iteration
+    // step for an action is a single dot-product over its successors.
+    class SimpleMGraph {
+    public:
+        explicit SimpleMGraph(const std::vector<SimpleMLearning>& clouds);
+
+        // Jacobi value iteration from the current values of the clouds until
+        // the largest change is at most epsilon, or max_iterations is reached.
+        // The result does not depend on the number of threads.
+        // Returns the number of iterations done.
+        size_t solve(bool minimization, double epsilon, size_t max_iterations, size_t threads = 1);
+
+        // writes the values of the last solve back into the clouds the graph
+        // was built from.
+        void store(std::vector<SimpleMLearning>& clouds, bool minimization) const;
+
+        double value(size_t cloud) const {
+            return _values[cloud];
+        }
+
+        double residual() const {
+            return _residual;
+        }
+
+    protected:
+        double iterate(size_t cloud, bool minimization);
+
+        std::vector<size_t> _cloud_offset; // actions of a cloud
+        std::vector<size_t> _action_offset; // successors of an action
+        std::vector<double> _cost; // expected cost per action
+        std::vector<size_t> _succ; // successor clouds
+        std::vector<double> _prob; // successor probabilities
+        std::vector<double> _q; // value per action
+        std::vector<double> _values, _next; // value per cloud
+        double _residual = 0;
+    };
+}
+
+#endif /* SIMPLEMGRAPH_H */
+
@@ -24,13 +24,28 @@
  */
 
 #include "SimpleMLearning.h"
+#include "threadpool.h"
+#include "trace.h"
+
 #include <iomanip>
+#include <chrono>
+#include <algorithm>
 
 namespace prlearn {
     SimpleMLearning::~SimpleMLearning() {
     }
 
+    SimpleMLearning::SimpleMLearning(const SimpleMLearning& other)
+    : _nodes(other._nodes, memory::current()), _q(other._q), _best(other._best) {
+    }
+
+    SimpleMLearning::node_t::node_t(const node_t& other)
+    : _q(other._q), _label(other._label), _succssors(other._succssors, memory::current()) {
+    }
+
     void SimpleMLearning::addSample(size_t, const double*, const double*, size_t*, size_t, size_t label, size_t dest, double value, const std::vector<SimpleMLearning>& clouds, bool minimization, const double, const propts_t& options) {
+        PRLEARN_TRACE_SPAN("SimpleMLearning::addSample");
+        memory::scope_t scope(_nodes.get_allocator().resource());
         node_t act;
         act._label = label;
         auto lb = std::lower_bound(std::begin(_nodes), std::end(_nodes), act);
@@ -45,8 +60,25 @@ namespace prlearn {
         value *= options._discount;
         le->_cost += value;
 
-        update(clouds, minimization);
+        // only the sampled action changed, the rest is cached in the nodes.
+        lb->update(clouds);
+        // without a best yet, _q is no value to compare with
+        if (_best == std::numeric_limits<size_t>::max() || better(lb->_q, _q, minimization)) {
+            _q = lb->_q;
+            _best = label;
+        } else if (_best == label) {
+            // the previous best got worse, find the new one
+            update_best(minimization);
+        }
+
+    }
 
+    std::vector<size_t> SimpleMLearning::labels() const {
+        std::vector<size_t> res;
+        res.reserve(_nodes.size());
+        for (auto& n : _nodes)
+            res.push_back(n._label);
+        return res;
     }
 
     qvar_t SimpleMLearning::lookup(size_t label, const double*, size_t) const {
@@ -95,33 +127,218 @@ namespace prlearn {
     }
 
     void SimpleMLearning::update(const std::vector<SimpleMLearning>& clouds, bool minimization) {
+        PRLEARN_TRACE_SPAN("SimpleMLearning::update");
+        for (auto& n : _nodes)
+            n.update(clouds);
+        update_best(minimization);
+    }
+
+    template<typename V>
+    void SimpleMLearning::node_t::update(V&& value) {
+        avg_t nq;
+
+        for (auto& s : _succssors) {
+            double dq = value(s._nid);
+            if (std::isinf(dq) || std::isnan(dq)) dq = 0;
+            nq.addPoints(s._cost.cnt(), s._cost.avg() + dq);
+        }
+        set_value(nq);
+    }
+
+    void SimpleMLearning::node_t::update(const std::vector<SimpleMLearning>& clouds) {
+        update([&clouds](size_t c) {
+            return clouds[c]._q.avg();
+        });
+    }
+
+    void SimpleMLearning::node_t::set_value(const avg_t& nq) {
+        avg_t nv;
+        for(auto& s : _succssors)
+        {
+            const auto dif = std::abs(s._cost.avg() - nq._avg);
+            const auto std = std::sqrt(s._cost._variance);
+            auto var = (std::pow(dif + std, 2.0) + std::pow(dif - std, 2.0)) / 2.0;
+            nv.addPoints(s._cost.cnt(), var);
+        }
+        _q = qvar_t(nq._avg, nq._cnt, nv._avg);
+    }
+
+    bool SimpleMLearning::better(const qvar_t& a, const qvar_t& b, bool minimization) {
+        if ((minimization && a.avg() <= b.avg()) ||
+                (!minimization && a.avg() >= b.avg()))
+            return a.avg() != b.avg() || a._variance < b._variance || a.cnt() > b.cnt();
+        return false;
+    }
+
+    void SimpleMLearning::update_best(bool minimization) {
         qvar_t rq;
         if (minimization) rq.avg() = std::numeric_limits<double>::infinity();
         else rq.avg() = -std::numeric_limits<double>::infinity();
+        _best = std::numeric_limits<size_t>::max();
         for (auto& n : _nodes) {
-            avg_t nq;
-            avg_t nv;
+            if (better(n._q, rq, minimization)) {
+                rq = n._q;
+                _best = n._label;
+            }
+        }
+        _q = rq;
+    }
+
+    SimpleMLearning::sweep_t SimpleMLearning::sweep(std::vector<SimpleMLearning>& clouds, bool minimization, double tolerance, double budget, size_t threads) {
+        PRLEARN_TRACE_SPAN("SimpleMLearning::sweep");
+        using clock = std::chrono::steady_clock;
+        const auto start = clock::now();
+        auto spent = [&] {
+            return std::chrono::duration<double>(clock::now() - start).count() >= budget;
+        };
+
+        const size_t n = clouds.size();
+        std::vector<std::vector<size_t>> preds(n);
+        for (size_t c = 0; c < n; ++c) {
+            for (auto& node : clouds[c]._nodes)
+                for (auto& s : node._succssors)
+                    preds[s._nid].push_back(c);
+        }
+        for (auto& p : preds) {
+            std::sort(p.begin(), p.end());
+            p.erase(std::unique(p.begin(), p.end()), p.end());
+        }
+
+        const size_t parts = std::max<size_t>(1, std::min(threads, n));
+        const size_t width = n == 0 ? 0 : (n + parts - 1) / parts;
+        // everything is pending to begin with
+        std::vector<double> pending(n, std::numeric_limits<double>::infinity());
+        std::vector<double> snapshot(n), current(n), change(n, 0);
+        std::vector<std::vector<size_t>> work(parts);
+        threadpool_t* pool = parts > 1 ? &threadpool_t::shared(parts) : nullptr;
 
-            for (auto& s : n._succssors) {
-                auto dq = clouds[s._nid]._q.avg();
-                if (std::isinf(dq) || std::isnan(dq)) dq = 0;
-                nq.addPoints(s._cost.cnt(), s._cost.avg() + dq);
+        sweep_t res;
+        while (true) {
+            for (size_t c = 0; c < n; ++c)
+                snapshot[c] = current[c] = clouds[c]._q.avg();
+            bool any = false;
+            for (size_t p = 0; p < parts; ++p) {
+                work[p].clear();
+                for (size_t c = p * width; c < std::min(n, (p + 1) * width); ++c) {
+                    if (pending[c] > tolerance && !clouds[c]._nodes.empty())
+                        work[p].push_back(c);
+                }
+                std::stable_sort(work[p].begin(), work[p].end(), [&](size_t a, size_t b) {
+                    return pending[a] > pending[b];
+                });
+                any |= !work[p].empty();
             }
-            for(auto& s : n._succssors)
-            {
-                const auto dif = std::abs(s._cost.avg() - nq._avg);
-                const auto std = std::sqrt(s._cost._variance);
-                auto var = (std::pow(dif + std, 2.0) + std::pow(dif - std, 2.0)) / 2.0;
-                nv.addPoints(s._cost.cnt(), var);
+            if (!any) {
+                res._converged = true;
+                break;
+            }
+            if (res._rounds > 0 && spent())
+                break;
+
+            auto round = [&](size_t p) {
+                const size_t first = p * width;
+                const size_t last = std::min(n, (p + 1) * width);
+                auto value = [&](size_t c) {
+                    return (c >= first && c < last) ? current[c] : snapshot[c];
+                };
+                for (auto c : work[p]) {
+                    auto& cloud = clouds[c];
+                    for (auto& node : cloud._nodes)
+                        node.update(value);
+                    cloud.update_best(minimization);
+                    auto v = cloud._q.avg();
+                    change[c] = v == current[c] ? 0 : std::abs(v - current[c]);
+                    current[c] = v;
+                }
+            };
+            if (pool)
+                pool->run(parts, round);
+            else
+                round(0);
+
+            // propagate the changes to the predecessors
+            ++res._rounds;
+            res._max_change = 0;
+            double sum = 0;
+            size_t cnt = 0;
+            for (auto& w : work) {
+                for (auto c : w) {
+                    pending[c] = 0;
+                    res._max_change = std::max(res._max_change, change[c]);
+                    sum += change[c];
+                    ++cnt;
+                }
             }
-            n._q = qvar_t(nq._avg, nq._cnt, nv._avg);
-            if ((minimization && n._q.avg() <= rq.avg()) ||
-                    (!minimization && n._q.avg() >= rq.avg())) {
-                if(n._q.avg() != rq.avg() || n._q._variance < rq._variance || n._q.cnt() > rq.cnt())
-                    rq = n._q;
+            for (auto& w : work) {
+                for (auto c : w) {
+                    for (auto p : preds[c])
+                        pending[p] = std::max(pending[p], change[c]);
+                }
             }
+            res._updates += cnt;
+            res._mean_change = sum / cnt;
         }
-        _q = rq;
+        return res;
+    }
+
+    void SimpleMLearning::write(std::ostream& s) const {
+        _q.write(s);
+        write_binary(s, &_best);
+        uint64_t n = _nodes.size();
+        write_binary(s, &n);
+        for (auto& node : _nodes) {
+            write_binary(s, &node._label);
+            node._q.write(s);
+            n = node._succssors.size();
+            write_binary(s, &n);
+            for (auto& succ : node._succssors) {
+                write_binary(s, &succ._nid);
+                succ._cost.write(s);
+            }
+        }
+    }
+
+    bool SimpleMLearning::read(std::istream& s, uint32_t version) {
+        // version 1 had no _best
+        if (version != checkpoint_version)
+            return false;
+        memory::scope_t scope(_nodes.get_allocator().resource());
+        uint64_t n;
+        if (!_q.read(s) || !read_binary(s, &_best) || !read_binary(s, &n))
+            return false;
+        // grown while read, the sizes are not trusted for allocation; both
+        // the actions and their successors are sorted, see addSample.
+        _nodes.clear();
+        for (uint64_t i = 0; i < n; ++i) {
+            node_t node;
+            uint64_t m;
+            if (!read_binary(s, &node._label) || !node._q.read(s) || !read_binary(s, &m))
+                return false;
+            for (uint64_t j = 0; j < m; ++j) {
+                succs_t succ;
+                // the costs are of sampled values, always finite
+                if (!read_binary(s, &succ._nid) || !succ._cost.read(s) ||
+                        !std::isfinite(succ._cost.avg()) || !std::isfinite(succ._cost._variance))
+                    return false;
+                if (!node._succssors.empty() && !(node._succssors.back() < succ))
+                    return false;
+                node._succssors.push_back(succ);
+            }
+            if (!_nodes.empty() && !(_nodes.back() < node))
+                return false;
+            _nodes.push_back(std::move(node));
+        }
+        return true;
+    }
+
+    bool SimpleMLearning::valid(const std::vector<SimpleMLearning>& clouds) const {
+        for (auto& node : _nodes) {
+            for (auto& succ : node._succssors) {
+                if (succ._nid >= clouds.size())
+                    return false;
+            }
+        }
+        return true;
     }
 
     bool SimpleMLearning::succs_t::operator<(const succs_t& other) const {
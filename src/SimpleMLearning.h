@@ -31,13 +31,16 @@
 
 #include <map>
 #include <limits>
+#include <cstdint>
 
 namespace prlearn {
 
+    class SimpleMGraph;
+
     class SimpleMLearning {
     public:
         SimpleMLearning() = default;
-        SimpleMLearning(const SimpleMLearning& other) = default;
+        SimpleMLearning(const SimpleMLearning& other);
         SimpleMLearning& operator=(const SimpleMLearning& other) = default;
 
         SimpleMLearning(SimpleMLearning&&) = default;
@@ -54,13 +57,50 @@ namespace prlearn {
                 const propts_t& options
                 );
 
+        // recomputes all actions; addSample only recomputes the sampled one.
         void update(const std::vector<SimpleMLearning>& clouds, bool minimization);
 
+        struct sweep_t {
+            size_t _rounds = 0;
+            size_t _updates = 0;
+            // change of the cloud-values in the last round
+            double _max_change = 0;
+            double _mean_change = 0;
+            bool _converged = false;
+        };
+
+        // Gauss-Seidel updates of the clouds, in rounds. Each round updates
+        // the clouds with a pending change above tolerance, largest first.
+        // Stops when no such cloud remains or the time budget (seconds) is
+        // spent. With threads > 1 the clouds are split into that many
+        // partitions; within a round these only see each others values from
+        // the start of the round. The result does not depend on timing.
+        static sweep_t sweep(std::vector<SimpleMLearning>& clouds, bool minimization,
+                double tolerance, double budget = std::numeric_limits<double>::infinity(),
+                size_t threads = 1);
+
         qvar_t lookup(size_t label, const double*, size_t) const;
 
+        // number of action-nodes, for statistics
+        size_t size() const {
+            return _nodes.size();
+        }
+
+        // the labels sampled so far, sorted
+        std::vector<size_t> labels() const;
+
         void print(std::ostream& s, size_t tabs, std::map<size_t, size_t>& label_map, const std::vector<SimpleMLearning>&) const;
 
+        // complete training state, see checkpoint.h
+        void write(std::ostream& s) const;
+        bool read(std::istream& s, uint32_t version);
+        // the references into the other clouds, after read
+        bool valid(const std::vector<SimpleMLearning>& clouds) const;
+        static constexpr uint32_t checkpoint_tag = 2;
+        static constexpr uint32_t checkpoint_version = 2;
+
     protected:
+        friend class SimpleMGraph;
 
         struct succs_t {
             size_t _nid = 0;
@@ -71,11 +111,27 @@ namespace prlearn {
         struct node_t {
             qvar_t _q;
             size_t _label = 0;
-            std::vector<succs_t> _succssors;
+            std::pmr::vector<succs_t> _succssors{memory::current()};
+            node_t() = default;
+            // the copy is in the current resource, see pmr.h
+            node_t(const node_t& other);
+            node_t(node_t&&) = default;
+            node_t& operator=(const node_t&) = default;
+            node_t& operator=(node_t&&) = default;
             bool operator<(const node_t& other) const;
+            void update(const std::vector<SimpleMLearning>& clouds);
+            template<typename V>
+            void update(V&& value);
+            void set_value(const avg_t& nq);
         };
-        std::vector<node_t> _nodes;
+
+        static bool better(const qvar_t& a, const qvar_t& b, bool minimization);
+        void update_best(bool minimization);
+
+        // in the resource current at construction, see pmr.h
+        std::pmr::vector<node_t> _nodes{memory::current()};
         qvar_t _q;
+        size_t _best = std::numeric_limits<size_t>::max(); // label of _q
     };
 }
 #endif /* SIMPLEMLEARNING_H */
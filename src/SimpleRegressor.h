@@ -38,10 +38,12 @@ namespace prlearn {
     class SimpleRegressor {
     public:
         SimpleRegressor() = default;
-        SimpleRegressor(const SimpleRegressor&) = default;
+        SimpleRegressor(const SimpleRegressor& other)
+        : _labels(other._labels, memory::current()) {
+        }
         SimpleRegressor(SimpleRegressor&&) = default;
 
-        qvar_t lookup(size_t label, const double*, size_t dimen) const {
+        qvar_t lookup(size_t label, const double*, size_t) const {
             el_t lf(label);
 
             auto res = std::lower_bound(std::begin(_labels), std::end(_labels), lf);
@@ -52,6 +54,11 @@ namespace prlearn {
                 return qvar_t{std::numeric_limits<double>::quiet_NaN(), 0, 0};
         }
 
+        // number of labels, for statistics
+        size_t size() const {
+            return _labels.size();
+        }
+
         double getBestQ(const double*, bool minimization, size_t* next_labels = nullptr, size_t n_labels = 0) const {
             double res = std::numeric_limits<double>::infinity();
             if (!minimization)
@@ -73,7 +80,7 @@ namespace prlearn {
             return res;
         }
 
-        void update(size_t label, const double*, size_t dimen, double nval, const double delta, const propts_t& options) {
+        void update(size_t label, const double*, size_t, double nval, const double, const propts_t& options) {
             el_t lf(label);
 
             auto res = std::lower_bound(std::begin(_labels), std::end(_labels), lf);
@@ -126,7 +133,8 @@ namespace prlearn {
                 return _label < other._label;
             }
         };
-        std::vector<el_t> _labels;
+        // in the resource current at construction, see pmr.h
+        std::pmr::vector<el_t> _labels{memory::current()};
 
     };
 
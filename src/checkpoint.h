@@ -0,0 +1,115 @@
+/*
+ * Copyright Peter G. Jensen
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * File:   checkpoint.h
+ * Author: Peter G. Jensen
+ *
+ * Created on October 17, 2026, 1:40 PM
+ */
+
+#ifndef CHECKPOINT_H
+#define CHECKPOINT_H
+
+#include "structs.h"
+#include "pmr.h"
+
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+#include <future>
+#include <fstream>
+#include <new>
+#include <stdexcept>
+
+namespace prlearn {
+
+    // Binary checkpoints of a vector of clouds (MLearning or SimpleMLearning),
+    // including everything needed to continue training. The format uses the
+    // native byte-order and is only meant to be read on the same platform.
+    // The layout of the clouds is versioned per learner, by its
+    // checkpoint_version; its read decides which versions it accepts.
+    constexpr uint32_t checkpoint_magic = 0x434c5250; // "PRLC"
+
+    template<typename Learner>
+    void write_checkpoint(std::ostream& s, const std::vector<Learner>& clouds) {
+        uint32_t header[4] = {checkpoint_magic, Learner::checkpoint_version,
+            (uint32_t) sizeof (size_t), Learner::checkpoint_tag};
+        write_binary(s, header, 4);
+        uint64_t n = clouds.size();
+        write_binary(s, &n);
+        for (auto& c : clouds)
+            c.write(s);
+    }
+
+    template<typename Learner>
+    bool read_checkpoint(std::istream& s, std::vector<Learner>& clouds) {
+        uint32_t header[4];
+        uint64_t n;
+        if (!read_binary(s, header, 4) || !read_binary(s, &n))
+            return false;
+        if (header[0] != checkpoint_magic || header[2] != sizeof (size_t) || header[3] != Learner::checkpoint_tag)
+            return false;
+        // a corrupt count may ask for more memory than there is
+        try {
+            std::vector<Learner> res;
+            for (uint64_t i = 0; i < n; ++i) {
+                res.emplace_back();
+                if (!res.back().read(s, header[1]))
+                    return false;
+            }
+            for (auto& c : res) {
+                if (!c.valid(res))
+                    return false;
+            }
+            clouds.swap(res);
+        } catch (const std::bad_alloc&) {
+            return false;
+        } catch (const std::length_error&) {
+            return false;
+        }
+        return true;
+    }
+
+    // Writes a snapshot of clouds in the background, so training can
+    // continue on the original meanwhile. The snapshot is a deep copy on the
+    // global heap, as it is freed by the writing thread. The file is written
+    // next to path and renamed when complete, so a crash never leaves a
+    // partial checkpoint behind.
+    template<typename Learner>
+    std::future<bool> write_checkpoint_async(const std::vector<Learner>& clouds, const std::string& path) {
+        std::vector<Learner> snapshot;
+        {
+            memory::scope_t scope(std::pmr::new_delete_resource());
+            snapshot = std::vector<Learner>(clouds);
+        }
+        return std::async(std::launch::async, [snapshot = std::move(snapshot), path] {
+            auto tmp = path + ".tmp";
+            {
+                std::ofstream out(tmp, std::ios::binary | std::ios::trunc);
+                write_checkpoint(out, snapshot);
+                out.flush();
+                if (!out) return false;
+            }
+            return std::rename(tmp.c_str(), path.c_str()) == 0;
+        });
+    }
+}
+
+#endif /* CHECKPOINT_H */
+
@@ -0,0 +1,112 @@
+/*
+ * Copyright Peter G. Jensen
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * File:   handle.h
+ * Author: Peter G. Jensen
+ *
+ * Created on October 18, 2026, 5:40 PM
+ */
+
+#ifndef HANDLE_H
+#define HANDLE_H
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace prlearn {
+
+    // A model (typically a vector of clouds) which can be replaced while it
+    // is in use. Readers acquire a snapshot and look up in it for as long as
+    // they hold it; swap publishes a new model for the following acquires.
+    //
+    //   model_handle_t<std::vector<MLearning>> handle(std::move(clouds));
+    //   auto model = handle.acquire();
+    //   auto q = (*model)[cloud].lookup(label, state, dimen);
+    //
+    // A replaced model is retired, not destroyed, and freed by a later
+    // reclaim once no snapshot of it is left; so neither a reader nor a swap
+    // pays for freeing it, and the retired models pile up until reclaim is
+    // called, e.g. periodically off the hot path. acquire is safe from any
+    // thread, swap and reclaim are serialized among themselves.
+    template<typename Model>
+    class model_handle_t {
+    public:
+        using snapshot_t = std::shared_ptr<const Model>;
+
+        explicit model_handle_t(std::shared_ptr<const Model> model = std::make_shared<const Model>())
+        : _model(std::move(model)) {
+        }
+
+        explicit model_handle_t(Model model)
+        : model_handle_t(std::make_shared<const Model>(std::move(model))) {
+        }
+
+        model_handle_t(const model_handle_t&) = delete;
+        model_handle_t& operator=(const model_handle_t&) = delete;
+
+        snapshot_t acquire() const {
+            return std::atomic_load_explicit(&_model, std::memory_order_acquire);
+        }
+
+        // publishes model and returns its version, counting from 0 for the
+        // model of the constructor.
+        uint64_t swap(std::shared_ptr<const Model> model) {
+            std::lock_guard<std::mutex> lock(_writer);
+            auto old = std::atomic_exchange_explicit(&_model, std::move(model), std::memory_order_acq_rel);
+            _retired.push_back(std::move(old));
+            return _version.fetch_add(1, std::memory_order_relaxed) + 1;
+        }
+
+        uint64_t swap(Model model) {
+            return swap(std::make_shared<const Model>(std::move(model)));
+        }
+
+        // frees the retired models without readers; returns the number
+        // still in use.
+        size_t reclaim() {
+            std::lock_guard<std::mutex> lock(_writer);
+            collect();
+            return _retired.size();
+        }
+
+        uint64_t version() const {
+            return _version.load(std::memory_order_relaxed);
+        }
+
+    private:
+
+        void collect() {
+            // the handle no longer gives out a retired model, so once the
+            // list holds the only reference it stays that way.
+            _retired.erase(std::remove_if(_retired.begin(), _retired.end(), [](const auto& m) {
+                return m.use_count() <= 1;
+            }), _retired.end());
+        }
+
+        std::shared_ptr<const Model> _model; // only through std::atomic_*
+        std::atomic<uint64_t> _version{0};
+        std::mutex _writer;
+        std::vector<std::shared_ptr<const Model>> _retired;
+    };
+}
+
+#endif /* HANDLE_H */
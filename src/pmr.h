@@ -0,0 +1,108 @@
+/*
+ * Copyright Peter G. Jensen
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * File:   pmr.h
+ * Author: Peter G. Jensen
+ *
+ * Created on October 17, 2026, 11:05 PM
+ */
+
+#ifndef PMR_H
+#define PMR_H
+
+#include <cstddef>
+#include <memory>
+#include <memory_resource>
+#include <vector>
+
+namespace prlearn {
+
+    // Memory resources (std::pmr) of the learners. A learner allocates all
+    // of its state from the resource which was current on the thread that
+    // constructed (or copied) it, e.g. a monotonic arena per cloud or a
+    // pool; the resource must outlive the learner. Without a scope_t the
+    // current resource is std::pmr::get_default_resource().
+    // Temporaries of a single update still use the global heap.
+    namespace memory {
+        inline thread_local std::pmr::memory_resource* _active = nullptr;
+
+        inline std::pmr::memory_resource* current() {
+            return _active != nullptr ? _active : std::pmr::get_default_resource();
+        }
+
+        class scope_t {
+        public:
+
+            explicit scope_t(std::pmr::memory_resource* resource) : _previous(_active) {
+                _active = resource;
+            }
+
+            ~scope_t() {
+                _active = _previous;
+            }
+            scope_t(const scope_t&) = delete;
+            scope_t& operator=(const scope_t&) = delete;
+        private:
+            std::pmr::memory_resource* _previous;
+        };
+    }
+
+    template<typename T>
+    class pmr_deleter_t {
+    public:
+        pmr_deleter_t() = default;
+
+        pmr_deleter_t(std::pmr::memory_resource* resource, size_t n)
+        : _resource(resource), _n(n) {
+        }
+
+        void operator()(T* data) const {
+            std::destroy_n(data, _n);
+            _resource->deallocate(data, _n * sizeof (T), alignof (T));
+        }
+
+        std::pmr::memory_resource* resource() const {
+            return _resource;
+        }
+    private:
+        std::pmr::memory_resource* _resource = nullptr;
+        size_t _n = 0;
+    };
+
+    // counterpart of std::unique_ptr<T[]>, from a memory resource
+    template<typename T>
+    using pmr_array_t = std::unique_ptr<T[], pmr_deleter_t<T>>;
+
+    // value-initialized, as std::make_unique<T[]>
+    template<typename T>
+    pmr_array_t<T> make_pmr_array(size_t n, std::pmr::memory_resource* resource = memory::current()) {
+        auto data = static_cast<T*> (resource->allocate(n * sizeof (T), alignof (T)));
+        std::uninitialized_value_construct_n(data, n);
+        return pmr_array_t<T>(data, pmr_deleter_t<T>(resource, n));
+    }
+
+    // shared ownership of an array, control-block included in its resource
+    template<typename T>
+    std::shared_ptr<const T[]> share_pmr_array(pmr_array_t<T>&& array) {
+        auto deleter = array.get_deleter();
+        return std::shared_ptr<const T[]>(array.release(), deleter,
+                std::pmr::polymorphic_allocator<char>(deleter.resource()));
+    }
+}
+
+#endif /* PMR_H */
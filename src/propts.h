@@ -27,6 +27,8 @@
 
 #include <cstddef>
 namespace prlearn {
+    class split_log_t;
+
     // primed for Q-learning
 
     struct propts_t {
@@ -41,6 +43,28 @@ namespace prlearn {
         double _filter_val = 0.99;
         double _discount = 0.99;
         double _indefference = 0.005;
+        // MLearning only; evaluate the split-candidates of nodes with at least
+        // _parallel_dimen dimensions on _threads threads.
+        // The result does not depend on the number of threads.
+        // A filter update costs about 10 ns per dimension and a dispatch on
+        // the pool some microseconds (prlearn_bench --micro --filter
+        // split-test), so only very wide nodes gain from it.
+        size_t _threads = 1;
+        size_t _parallel_dimen = 1024;
+        // MLearning only; with 0 the statistics from before a split are kept
+        // aside (old) until the new ones outweigh them. With a weight in (0, 1]
+        // they are instead kept as current statistics with their counts
+        // scaled by the weight, halving the memory of a future.
+        double _split_decay = 0;
+        // RefinementTree and MLearning; receives every split and rezero,
+        // see splitlog.h. Not owned.
+        split_log_t* _split_log = nullptr;
+
+        // false for options the learners cannot work with; to be checked
+        // wherever options are parsed or read.
+        bool valid() const {
+            return _split_decay == 0 || (_split_decay > 0 && _split_decay <= 1);
+        }
     };
 }
 
@@ -0,0 +1,402 @@
+/*
+ * Copyright Peter G. Jensen
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * File:   recorder.cpp
+ * Author: Peter G. Jensen
+ *
+ * Created on October 18, 2026, 9:10 AM
+ */
+
+#include "recorder.h"
+#include "structs.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace prlearn {
+
+    constexpr uint32_t sample_log_magic = 0x524c5250; // "PRLR"
+    // version 2 added the seed to the header
+    constexpr uint32_t sample_log_version = 2;
+
+    // the flags leading each sample
+    enum sample_flags_t : uint8_t {
+        MINIMIZATION = 1, ALL_LABELS = 2, HAS_DELTA = 4, HAS_OPTIONS = 8, SAME_LABELS = 16
+    };
+
+    // the options as stored, in order; _split_log is left out
+    constexpr size_t option_words = 11;
+
+    static void pack(const propts_t& o, uint64_t* words) {
+        double d[8] = {o._upper_t, o._lower_t, o._ks_limit, o._filter_rate,
+            o._filter_val, o._discount, o._indefference, o._split_decay};
+        words[0] = o._q_learn_rate;
+        words[1] = o._threads;
+        words[2] = o._parallel_dimen;
+        memcpy(words + 3, d, sizeof (d));
+    }
+
+    static void unpack(const uint64_t* words, propts_t& o) {
+        double d[8];
+        memcpy(d, words + 3, sizeof (d));
+        o._q_learn_rate = words[0];
+        o._threads = words[1];
+        o._parallel_dimen = words[2];
+        o._upper_t = d[0];
+        o._lower_t = d[1];
+        o._ks_limit = d[2];
+        o._filter_rate = d[3];
+        o._filter_val = d[4];
+        o._discount = d[5];
+        o._indefference = d[6];
+        o._split_decay = d[7];
+        o._split_log = nullptr;
+    }
+
+    static uint64_t bits_of(double value, bool narrow) {
+        if (narrow) {
+            float f = (float) value;
+            uint32_t b;
+            memcpy(&b, &f, sizeof (b));
+            return b;
+        }
+        uint64_t b;
+        memcpy(&b, &value, sizeof (b));
+        return b;
+    }
+
+    static double value_of(uint64_t bits, bool narrow) {
+        if (narrow) {
+            uint32_t b = (uint32_t) bits;
+            float f;
+            memcpy(&f, &b, sizeof (f));
+            return f;
+        }
+        double d;
+        memcpy(&d, &bits, sizeof (d));
+        return d;
+    }
+
+    static uint64_t zigzag(int64_t v) {
+        return ((uint64_t) v << 1) ^ (uint64_t) (v >> 63);
+    }
+
+    static int64_t unzigzag(uint64_t v) {
+        return (int64_t) (v >> 1) ^ -(int64_t) (v & 1);
+    }
+
+    sample_recorder_t::sample_recorder_t(std::ostream& stream, uint8_t compression, size_t block_size, unsigned seed)
+    : _stream(stream), _compression(compression), _block_size(std::max<size_t>(block_size, 256)) {
+        uint32_t header[4] = {sample_log_magic, sample_log_version, compression, seed};
+        write_binary(_stream, header, 4);
+        _bytes = sizeof (header);
+        reserve(_block_size + 1024);
+    }
+
+    uint8_t* sample_recorder_t::reserve(size_t bytes) {
+        if (_used + bytes > _capacity) {
+            _capacity = std::max(2 * _capacity, _used + bytes);
+            auto block = std::make_unique<uint8_t[]>(_capacity);
+            if (_used > 0)
+                memcpy(block.get(), _block.get(), _used);
+            _block = std::move(block);
+        }
+        return _block.get() + _used;
+    }
+
+    sample_recorder_t::~sample_recorder_t() {
+        flush();
+    }
+
+    static uint8_t* put_varint(uint8_t* out, uint64_t value) {
+        while (value >= 0x80) {
+            *out++ = (uint8_t) (value | 0x80);
+            value >>= 7;
+        }
+        *out++ = (uint8_t) value;
+        return out;
+    }
+
+    // zero bytes at the low and high end of a non-zero value
+    static size_t low_zero_bytes(uint64_t bits) {
+#if defined(__GNUC__)
+        return __builtin_ctzll(bits) / 8;
+#else
+        size_t n = 0;
+        for (; (bits & 0xff) == 0; bits >>= 8) ++n;
+        return n;
+#endif
+    }
+
+    static size_t high_zero_bytes(uint64_t bits) {
+#if defined(__GNUC__)
+        return __builtin_clzll(bits) / 8;
+#else
+        size_t n = 0;
+        for (; (bits >> 56) == 0; bits <<= 8) ++n;
+        return n;
+#endif
+    }
+
+    uint8_t* sample_recorder_t::put_double(uint8_t* out, double value, double previous, bool narrow) const {
+        const size_t width = narrow ? 4 : 8;
+        uint64_t bits = bits_of(value, narrow);
+        if ((_compression & DELTA) == 0) {
+            for (size_t b = 0; b < width; ++b)
+                *out++ = (uint8_t) (bits >> (8 * b));
+            return out;
+        }
+        // a byte with the number of leading (high) and trailing (low) zero
+        // bytes of the xor, followed by the bytes in between.
+        bits ^= bits_of(previous, narrow);
+        if (bits == 0) {
+            *out++ = (uint8_t) (width << 4);
+            return out;
+        }
+        const size_t low = low_zero_bytes(bits);
+        const size_t high = 8 - high_zero_bytes(bits);
+        *out++ = (uint8_t) (((width - high) << 4) | low);
+        for (size_t b = low; b < high; ++b)
+            *out++ = (uint8_t) (bits >> (8 * b));
+        return out;
+    }
+
+    void sample_recorder_t::record(size_t location, size_t dimen, const double* f_var, const double* t_var,
+            const size_t* next_labels, size_t n_labels, size_t label, size_t dest, double value,
+            bool minimization, double delta, const propts_t& options) {
+        uint64_t words[option_words];
+        static_assert(sizeof (words) == sizeof (_options), "the packed options");
+        pack(options, words);
+        const bool narrow = (_compression & FLOAT) != 0;
+        if (next_labels == nullptr)
+            n_labels = 0;
+        std::lock_guard<std::mutex> lock(_lock);
+        // every block starts over, so the first sample carries it all
+        const bool first = _block_samples == 0;
+        if (first || _from.size() != dimen)
+            _from.assign(dimen, 0);
+        const bool has_delta = first || bits_of(delta, false) != bits_of(_delta, false);
+        const bool has_options = first || memcmp(words, _options, sizeof (words)) != 0;
+        // mostly the same few sets of next-labels
+        const bool same_labels = !first && next_labels != nullptr && n_labels == _next.size() &&
+                std::equal(next_labels, next_labels + n_labels, _next.begin());
+
+        // room for the worst case, trimmed after
+        uint8_t* const start = reserve(1 + 10 * (5 + n_labels + option_words) + 9 * (2 + 2 * dimen));
+        uint8_t* out = start;
+        *out++ = (minimization ? MINIMIZATION : 0) | (next_labels == nullptr ? ALL_LABELS : 0) |
+                (has_delta ? HAS_DELTA : 0) | (has_options ? HAS_OPTIONS : 0) | (same_labels ? SAME_LABELS : 0);
+        out = put_varint(out, location);
+        out = put_varint(out, dimen);
+        out = put_varint(out, label);
+        out = put_varint(out, dest);
+        if (next_labels != nullptr && !same_labels) {
+            _next.assign(next_labels, next_labels + n_labels);
+            // sorted, so the differences are small
+            out = put_varint(out, n_labels);
+            size_t prev = 0;
+            for (size_t i = 0; i < n_labels; ++i) {
+                out = put_varint(out, zigzag((int64_t) (next_labels[i] - prev)));
+                prev = next_labels[i];
+            }
+        }
+        out = put_double(out, value, first ? 0 : _value, false);
+        _value = value;
+        for (size_t d = 0; d < dimen; ++d) {
+            out = put_double(out, f_var[d], _from[d], narrow);
+            out = put_double(out, t_var[d], f_var[d], narrow);
+            _from[d] = f_var[d];
+        }
+        if (has_delta) {
+            out = put_double(out, delta, 0, false);
+            _delta = delta;
+        }
+        if (has_options) {
+            for (auto w : words)
+                out = put_varint(out, w);
+            memcpy(_options, words, sizeof (words));
+        }
+        _used += out - start;
+        ++_block_samples;
+        ++_samples;
+        if (_used >= _block_size)
+            write_block();
+    }
+
+    void sample_recorder_t::write_block() {
+        if (_block_samples == 0) return;
+        uint32_t header[2] = {(uint32_t) _used, _block_samples};
+        write_binary(_stream, header, 2);
+        write_binary(_stream, _block.get(), _used);
+        _bytes += sizeof (header) + _used;
+        _used = 0;
+        _block_samples = 0;
+    }
+
+    bool sample_recorder_t::flush() {
+        std::lock_guard<std::mutex> lock(_lock);
+        write_block();
+        _stream.flush();
+        return (bool)_stream;
+    }
+
+    sample_reader_t::sample_reader_t(std::istream& stream) : _stream(stream) {
+        uint32_t header[3];
+        _valid = read_binary(_stream, header, 3) && header[0] == sample_log_magic &&
+                header[1] >= 1 && header[1] <= sample_log_version &&
+                header[2] <= (sample_recorder_t::DELTA | sample_recorder_t::FLOAT);
+        if (_valid && header[1] >= 2) {
+            uint32_t seed;
+            _valid = read_binary(_stream, &seed);
+            _seed = seed;
+        }
+        if (_valid)
+            _compression = header[2];
+    }
+
+    bool sample_reader_t::read_block() {
+        uint32_t header[2];
+        if (!read_binary(_stream, header, 2)) {
+            // a partial header is a cut-off block
+            _truncated = _stream.gcount() != 0;
+            return false;
+        }
+        // far beyond any block written; a broken header
+        if (header[0] > (1u << 28)) {
+            _truncated = true;
+            return false;
+        }
+        _block.resize(header[0]);
+        _pos = 0;
+        _block_samples = header[1];
+        if (header[1] == 0 || !read_binary(_stream, _block.data(), _block.size())) {
+            _truncated = true;
+            return false;
+        }
+        return true;
+    }
+
+    bool sample_reader_t::get_varint(uint64_t& value) {
+        value = 0;
+        for (size_t shift = 0; shift < 64 && _pos < _block.size(); shift += 7) {
+            const uint8_t b = _block[_pos++];
+            value |= (uint64_t) (b & 0x7f) << shift;
+            if ((b & 0x80) == 0)
+                return true;
+        }
+        return false;
+    }
+
+    bool sample_reader_t::get_double(double& value, double previous, bool narrow) {
+        const size_t width = narrow ? 4 : 8;
+        uint64_t bits = 0;
+        size_t low = 0, high = width;
+        if ((_compression & sample_recorder_t::DELTA) != 0) {
+            if (_pos >= _block.size()) return false;
+            const uint8_t tag = _block[_pos++];
+            low = tag & 0xf;
+            high = width - (tag >> 4);
+            if ((tag >> 4) > width || low > high) return false;
+        }
+        if (_block.size() - _pos < high - low) return false;
+        for (size_t b = low; b < high; ++b)
+            bits |= (uint64_t) _block[_pos++] << (8 * b);
+        if ((_compression & sample_recorder_t::DELTA) != 0)
+            bits ^= bits_of(previous, narrow);
+        value = value_of(bits, narrow);
+        return true;
+    }
+
+    bool sample_reader_t::decode(sample_t& s) {
+        const bool narrow = (_compression & sample_recorder_t::FLOAT) != 0;
+        const bool first = _pos == 0;
+        if (_pos >= _block.size()) return false;
+        const uint8_t flags = _block[_pos++];
+        uint64_t location, dimen, label, dest, n_labels = 0;
+        if (!get_varint(location) || !get_varint(dimen) || !get_varint(label) || !get_varint(dest))
+            return false;
+        // each state takes at least a byte
+        if (dimen > _block.size() - _pos)
+            return false;
+        s._location = location;
+        s._dimen = dimen;
+        s._label = label;
+        s._dest = dest;
+        s._minimization = (flags & MINIMIZATION) != 0;
+        s._all_labels = (flags & ALL_LABELS) != 0;
+        s._next.clear();
+        if (!s._all_labels && (flags & SAME_LABELS) != 0) {
+            if (first) return false;
+            s._next = _next;
+        } else if (!s._all_labels) {
+            if (!get_varint(n_labels) || n_labels > _block.size() - _pos)
+                return false;
+            s._next.resize(n_labels);
+            size_t prev = 0;
+            for (auto& l : s._next) {
+                uint64_t d;
+                if (!get_varint(d)) return false;
+                l = prev = prev + unzigzag(d);
+            }
+            _next = s._next;
+        }
+        if (first || _from.size() != dimen)
+            _from.assign(dimen, 0);
+        if (!get_double(s._value, first ? 0 : _value, false))
+            return false;
+        _value = s._value;
+        s._from.resize(dimen);
+        s._to.resize(dimen);
+        for (size_t d = 0; d < dimen; ++d) {
+            if (!get_double(s._from[d], _from[d], narrow) || !get_double(s._to[d], s._from[d], narrow))
+                return false;
+            _from[d] = s._from[d];
+        }
+        if ((flags & HAS_DELTA) != 0 && !get_double(_delta, 0, false))
+            return false;
+        if ((flags & HAS_OPTIONS) != 0) {
+            uint64_t words[option_words];
+            for (auto& w : words)
+                if (!get_varint(w)) return false;
+            unpack(words, _options);
+            if (!_options.valid())
+                return false;
+        }
+        if (first && ((flags & HAS_DELTA) == 0 || (flags & HAS_OPTIONS) == 0))
+            return false;
+        s._delta = _delta;
+        s._options = _options;
+        return true;
+    }
+
+    bool sample_reader_t::next(sample_t& sample) {
+        if (!_valid || _truncated)
+            return false;
+        if (_block_samples == 0 && !read_block())
+            return false;
+        if (!decode(sample)) {
+            _truncated = true;
+            return false;
+        }
+        if (--_block_samples == 0 && _pos != _block.size()) {
+            _truncated = true;
+            return false;
+        }
+        return true;
+    }
+}
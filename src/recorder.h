@@ -0,0 +1,182 @@
+/*
+ * Copyright Peter G. Jensen
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * File:   recorder.h
+ * Author: Peter G. Jensen
+ *
+ * Created on October 18, 2026, 9:10 AM
+ */
+
+#ifndef RECORDER_H
+#define RECORDER_H
+
+#include "propts.h"
+
+#include <cstdint>
+#include <cstddef>
+#include <istream>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <vector>
+
+namespace prlearn {
+
+    // A single call of addSample, as recorded
+    struct sample_t {
+        size_t _location = 0; // the cloud receiving the sample
+        size_t _dimen = 0;
+        std::vector<double> _from, _to;
+        // next_labels was a nullptr (all labels), otherwise _next
+        bool _all_labels = true;
+        std::vector<size_t> _next;
+        size_t _label = 0;
+        size_t _dest = 0;
+        double _value = 0;
+        bool _minimization = true;
+        double _delta = 1;
+        propts_t _options; // without the _split_log
+
+        size_t* next_labels() {
+            return _all_labels ? nullptr : _next.data();
+        }
+    };
+
+    // Appends the calls of addSample to a binary log. Samples are collected
+    // in blocks of about block_size bytes which are written whole, so a log
+    // cut short (by a crash) loses at most the last block. Each block can be
+    // decoded on its own.
+    //
+    // With DELTA the doubles are stored as the bytes of their xor with the
+    // value before (the previous state, the state for the next-state),
+    // which for slowly changing or integral values is a byte or two. With
+    // FLOAT the states are narrowed to floats, losing precision. The options,
+    // delta and next-labels are only stored when they change. The header
+    // keeps the seed of std::rand in the recorded run, which the learners
+    // break ties with, so a replay can reproduce it.
+    class sample_recorder_t {
+    public:
+        enum compression_t : uint8_t {
+            RAW = 0, DELTA = 1, FLOAT = 2
+        };
+
+        explicit sample_recorder_t(std::ostream& stream, uint8_t compression = DELTA, size_t block_size = 1 << 16, unsigned seed = 1);
+        ~sample_recorder_t();
+
+        // Safe for learners trained on different threads.
+        void record(size_t location, size_t dimen, const double* f_var, const double* t_var,
+                const size_t* next_labels, size_t n_labels, size_t label, size_t dest, double value,
+                bool minimization, double delta, const propts_t& options);
+
+        // records the sample and passes it on to clouds[location]
+        template<typename Learner>
+        void addSample(size_t location, size_t dimen, const double* f_var, const double* t_var,
+                size_t* next_labels, size_t n_labels, size_t label, size_t dest, double value,
+                std::vector<Learner>& clouds, bool minimization, const double delta, const propts_t& options) {
+            record(location, dimen, f_var, t_var, next_labels, n_labels, label, dest, value, minimization, delta, options);
+            clouds[location].addSample(dimen, f_var, t_var, next_labels, n_labels, label, dest, value,
+                    clouds, minimization, delta, options);
+        }
+
+        // writes the current block; false if the stream failed
+        bool flush();
+
+        size_t samples() const {
+            return _samples;
+        }
+
+        // written so far, including the headers
+        size_t bytes() const {
+            return _bytes;
+        }
+
+    private:
+        void write_block();
+        uint8_t* reserve(size_t bytes);
+        uint8_t* put_double(uint8_t* out, double value, double previous, bool narrow) const;
+
+        std::ostream& _stream;
+        std::mutex _lock;
+        const uint8_t _compression;
+        const size_t _block_size;
+        // the current block; not a vector, which would zero what reserve hands out
+        std::unique_ptr<uint8_t[]> _block;
+        size_t _used = 0, _capacity = 0;
+        uint32_t _block_samples = 0;
+        size_t _samples = 0;
+        size_t _bytes = 0;
+        // previous values within the block, for DELTA
+        std::vector<double> _from;
+        double _value = 0;
+        double _delta = 0;
+        // the next-labels and (packed) options last stored
+        std::vector<size_t> _next;
+        uint64_t _options[11] = {};
+    };
+
+    // Reads a log of sample_recorder_t, sample by sample.
+    class sample_reader_t {
+    public:
+        explicit sample_reader_t(std::istream& stream);
+
+        // false if the header is not one of a sample log
+        bool valid() const {
+            return _valid;
+        }
+
+        // false at the end of the log, or at the first broken block
+        bool next(sample_t& sample);
+
+        // the log ended within a block, or a block could not be decoded
+        bool truncated() const {
+            return _truncated;
+        }
+
+        uint8_t compression() const {
+            return _compression;
+        }
+
+        // of std::rand in the recorded run; 1 for logs of version 1, which
+        // did not store it
+        unsigned seed() const {
+            return _seed;
+        }
+
+    private:
+        bool read_block();
+        bool decode(sample_t& sample);
+        bool get_varint(uint64_t& value);
+        bool get_double(double& value, double previous, bool narrow);
+
+        std::istream& _stream;
+        bool _valid = false;
+        bool _truncated = false;
+        uint8_t _compression = 0;
+        unsigned _seed = 1;
+        std::vector<uint8_t> _block;
+        size_t _pos = 0;
+        uint32_t _block_samples = 0;
+        std::vector<double> _from;
+        double _value = 0;
+        double _delta = 0;
+        std::vector<size_t> _next;
+        propts_t _options;
+    };
+}
+
+#endif /* RECORDER_H */
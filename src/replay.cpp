@@ -0,0 +1,110 @@
+/*
+ * Copyright Peter G. Jensen
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * File:   replay.cpp
+ * Author: Peter G. Jensen
+ *
+ * Created on October 18, 2026, 11:30 AM
+ */
+
+#include "replay.h"
+
+namespace prlearn {
+
+    sample_source_t::sample_source_t(std::istream& stream, bool prefetch)
+    : _reader(stream), _prefetch(prefetch && _reader.valid()) {
+        if (!_prefetch)
+            return;
+        // the samples of a batch keep their buffers when recycled
+        _free.resize(batches);
+        for (auto& b : _free)
+            b._samples.resize(batch_size);
+        _thread = std::thread([this] {
+            decode();
+        });
+    }
+
+    sample_source_t::~sample_source_t() {
+        if (!_thread.joinable())
+            return;
+        {
+            std::lock_guard<std::mutex> lock(_lock);
+            _stop = true;
+        }
+        _cond.notify_all();
+        _thread.join();
+    }
+
+    void sample_source_t::fill(batch_t& batch) {
+        batch._size = 0;
+        while (batch._size < batch._samples.size() && _reader.next(batch._samples[batch._size]))
+            ++batch._size;
+    }
+
+    void sample_source_t::decode() {
+        while (true) {
+            batch_t batch;
+            {
+                std::unique_lock<std::mutex> lock(_lock);
+                _cond.wait(lock, [this] {
+                    return _stop || !_free.empty();
+                });
+                if (_stop) return;
+                batch = std::move(_free.back());
+                _free.pop_back();
+            }
+            fill(batch);
+            const bool end = batch._size < batch._samples.size();
+            {
+                std::lock_guard<std::mutex> lock(_lock);
+                _full.push_back(std::move(batch));
+                _done = end;
+            }
+            _cond.notify_all();
+            if (end) return;
+        }
+    }
+
+    sample_t* sample_source_t::next() {
+        if (_pos < _current._size)
+            return &_current._samples[_pos++];
+        _pos = 0;
+        if (!_prefetch) {
+            if (_current._samples.empty())
+                _current._samples.resize(batch_size);
+            fill(_current);
+        } else {
+            std::unique_lock<std::mutex> lock(_lock);
+            if (!_current._samples.empty()) {
+                _free.push_back(std::move(_current));
+                _current = batch_t();
+                _cond.notify_all();
+            }
+            _cond.wait(lock, [this] {
+                return _done || !_full.empty();
+            });
+            if (_full.empty()) {
+                _current = batch_t();
+                return nullptr;
+            }
+            _current = std::move(_full.front());
+            _full.pop_front();
+        }
+        return _current._size > 0 ? &_current._samples[_pos++] : nullptr;
+    }
+}
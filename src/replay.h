@@ -0,0 +1,151 @@
+/*
+ * Copyright Peter G. Jensen
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * File:   replay.h
+ * Author: Peter G. Jensen
+ *
+ * Created on October 18, 2026, 11:30 AM
+ */
+
+#ifndef REPLAY_H
+#define REPLAY_H
+
+#include "recorder.h"
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstdlib>
+#include <deque>
+#include <limits>
+#include <optional>
+#include <thread>
+
+namespace prlearn {
+
+    // The samples of a log of sample_recorder_t, in order. With prefetch the
+    // log is decoded ahead on a thread of its own, in batches.
+    class sample_source_t {
+    public:
+        sample_source_t(std::istream& stream, bool prefetch);
+        ~sample_source_t();
+
+        bool valid() const {
+            return _reader.valid();
+        }
+
+        // see sample_reader_t::seed
+        unsigned seed() const {
+            return _reader.seed();
+        }
+
+        // the next sample, until the next call; nullptr at the end
+        sample_t* next();
+
+        // see sample_reader_t::truncated, once next has returned nullptr
+        bool truncated() const {
+            return _reader.truncated();
+        }
+
+    private:
+        struct batch_t {
+            std::vector<sample_t> _samples;
+            size_t _size = 0;
+        };
+        static constexpr size_t batch_size = 256;
+        static constexpr size_t batches = 4;
+
+        void fill(batch_t& batch);
+        void decode();
+
+        sample_reader_t _reader;
+        const bool _prefetch;
+        batch_t _current;
+        size_t _pos = 0;
+        std::mutex _lock;
+        std::condition_variable _cond;
+        std::deque<batch_t> _full;
+        std::vector<batch_t> _free;
+        bool _done = false, _stop = false;
+        std::thread _thread;
+    };
+
+    struct replay_options_t {
+        // the learners break ties with std::rand, which is seeded with this
+        // before the first sample; by default the seed stored in the log.
+        std::optional<unsigned> _seed;
+        // replaces propts_t::_threads of the samples when non-zero; the
+        // models do not depend on it.
+        size_t _threads = 0;
+        split_log_t* _split_log = nullptr;
+        // decode ahead on a second thread; costs on a single core
+        bool _prefetch = std::thread::hardware_concurrency() > 1;
+        size_t _limit = std::numeric_limits<size_t>::max();
+        // the replay stops at a sample of a cloud (or dest) from this on,
+        // rather than growing the clouds to it
+        size_t _max_clouds = 1 << 16;
+    };
+
+    struct replay_stats_t {
+        size_t _samples = 0;
+        double _seconds = 0;
+        // see sample_reader_t::truncated
+        bool _truncated = false;
+        // stopped at a sample beyond replay_options_t::_max_clouds
+        bool _beyond_max_clouds = false;
+
+        double samples_per_sec() const {
+            return _seconds > 0 ? _samples / _seconds : 0;
+        }
+    };
+
+    // Feeds the samples of the log into the clouds, as recorded, adding
+    // clouds as needed. Into fresh clouds this reproduces the recorded
+    // model exactly. False if the log is not one of sample_recorder_t.
+    template<typename Learner>
+    bool replay(std::istream& log, std::vector<Learner>& clouds, replay_stats_t& stats,
+            const replay_options_t& options = replay_options_t()) {
+        sample_source_t source(log, options._prefetch);
+        if (!source.valid())
+            return false;
+        stats = replay_stats_t();
+        std::srand(options._seed.value_or(source.seed()));
+        const auto start = std::chrono::steady_clock::now();
+        sample_t* s;
+        for (; stats._samples < options._limit && (s = source.next()) != nullptr; ++stats._samples) {
+            if (s->_location >= options._max_clouds || s->_dest >= options._max_clouds) {
+                stats._beyond_max_clouds = true;
+                break;
+            }
+            const size_t n = std::max(s->_location, s->_dest) + 1;
+            if (clouds.size() < n)
+                clouds.resize(n);
+            if (options._threads > 0)
+                s->_options._threads = options._threads;
+            s->_options._split_log = options._split_log;
+            clouds[s->_location].addSample(s->_dimen, s->_from.data(), s->_to.data(),
+                    s->next_labels(), s->_next.size(), s->_label, s->_dest, s->_value,
+                    clouds, s->_minimization, s->_delta, s->_options);
+        }
+        stats._seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        stats._truncated = stats._samples < options._limit && !stats._beyond_max_clouds && source.truncated();
+        return true;
+    }
+}
+
+#endif /* REPLAY_H */
@@ -0,0 +1,94 @@
+/*
+ * Copyright Peter G. Jensen
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * File:   splitlog.cpp
+ * Author: Peter G. Jensen
+ *
+ * Created on October 17, 2026, 10:20 PM
+ */
+
+#include "splitlog.h"
+#include "structs.h"
+
+namespace prlearn {
+
+    constexpr uint32_t split_log_magic = 0x534c5250; // "PRLS"
+    constexpr uint32_t split_log_version = 1;
+
+    void split_event_t::print(std::ostream& s) const {
+        static const char* filters[] = {"none", "variance", "high", "low"};
+        if (_kind == SPLIT) {
+            s << "split label=" << _label << " node=" << _node << " parent=" << _parent
+                    << " low=" << _low << " high=" << _high << " dim=" << _dimension
+                    << " boundary=" << _boundary << " filter=" << filters[_filter];
+        } else {
+            s << "rezero label=" << _label << " node=" << _node << " parent=" << _parent
+                    << " dim=" << _dimension << " midpoint=" << _previous << "->" << _boundary;
+        }
+        s << " counts=" << _low_count << "/" << _high_count;
+    }
+
+    split_event_t::filter_t split_event_t::trigger(double vfilter, double hfilter, double lfilter) {
+        if (vfilter >= hfilter && vfilter >= lfilter)
+            return VARIANCE;
+        return hfilter >= lfilter ? HIGH : LOW;
+    }
+
+    split_stream_t::split_stream_t(std::ostream& stream) : _stream(stream) {
+        uint32_t header[2] = {split_log_magic, split_log_version};
+        write_binary(_stream, header, 2);
+    }
+
+    void split_stream_t::record(const split_event_t& e) {
+        uint8_t tags[2] = {e._kind, e._filter};
+        uint64_t ids[6] = {e._label, e._node, e._parent, e._low, e._high, e._dimension};
+        double values[4] = {e._boundary, e._previous, e._low_count, e._high_count};
+        std::lock_guard<std::mutex> lock(_lock);
+        write_binary(_stream, tags, 2);
+        write_binary(_stream, ids, 6);
+        write_binary(_stream, values, 4);
+    }
+
+    bool read_split_log_header(std::istream& s) {
+        uint32_t header[2];
+        return read_binary(s, header, 2) && header[0] == split_log_magic && header[1] == split_log_version;
+    }
+
+    bool read_split_event(std::istream& s, split_event_t& e) {
+        uint8_t tags[2];
+        uint64_t ids[6];
+        double values[4];
+        if (!read_binary(s, tags, 2) || !read_binary(s, ids, 6) || !read_binary(s, values, 4))
+            return false;
+        if (tags[0] > split_event_t::REZERO || tags[1] > split_event_t::LOW)
+            return false;
+        e._kind = (split_event_t::kind_t) tags[0];
+        e._filter = (split_event_t::filter_t) tags[1];
+        e._label = ids[0];
+        e._node = ids[1];
+        e._parent = ids[2];
+        e._low = ids[3];
+        e._high = ids[4];
+        e._dimension = ids[5];
+        e._boundary = values[0];
+        e._previous = values[1];
+        e._low_count = values[2];
+        e._high_count = values[3];
+        return true;
+    }
+}
@@ -0,0 +1,104 @@
+/*
+ * Copyright Peter G. Jensen
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * File:   splitlog.h
+ * Author: Peter G. Jensen
+ *
+ * Created on October 17, 2026, 10:20 PM
+ */
+
+#ifndef SPLITLOG_H
+#define SPLITLOG_H
+
+#include <cstdint>
+#include <cstddef>
+#include <functional>
+#include <istream>
+#include <mutex>
+#include <ostream>
+
+namespace prlearn {
+
+    // A split of a node in a RefinementTree or MLearning, or the re-centering
+    // (rezero) of the split-candidate of a dimension.
+    struct split_event_t {
+
+        enum kind_t : uint8_t {
+            SPLIT, REZERO
+        };
+
+        // the filter of splitfilter_t which reached the critical value
+        enum filter_t : uint8_t {
+            NONE, VARIANCE, HIGH, LOW
+        };
+
+        kind_t _kind = SPLIT;
+        filter_t _filter = NONE;
+        size_t _label = 0;
+        size_t _node = 0;
+        size_t _parent = 0; // root is its own parent
+        size_t _low = 0, _high = 0; // children, split only
+        size_t _dimension = 0;
+        double _boundary = 0; // of the split, or the new midpoint
+        double _previous = 0; // the old midpoint, rezero only
+        // points seen on either side of the boundary (before a rezero)
+        double _low_count = 0, _high_count = 0;
+
+        void print(std::ostream& s) const;
+        // the filter with the highest value, VARIANCE on ties
+        static filter_t trigger(double vfilter, double hfilter, double lfilter);
+    };
+
+    // Set as propts_t::_split_log to receive the events; called by the thread
+    // that trains the learner.
+    class split_log_t {
+    public:
+        virtual ~split_log_t() = default;
+        virtual void record(const split_event_t& event) = 0;
+    };
+
+    class split_callback_t : public split_log_t {
+    public:
+        explicit split_callback_t(std::function<void(const split_event_t&) > callback)
+        : _callback(std::move(callback)) {
+        }
+
+        void record(const split_event_t& event) override {
+            _callback(event);
+        }
+    private:
+        std::function<void(const split_event_t&) > _callback;
+    };
+
+    // Binary event stream; a header followed by fixed-size records in the
+    // native byte-order, see read_split_event. Safe for learners trained on
+    // different threads.
+    class split_stream_t : public split_log_t {
+    public:
+        explicit split_stream_t(std::ostream& stream);
+        void record(const split_event_t& event) override;
+    private:
+        std::ostream& _stream;
+        std::mutex _lock;
+    };
+
+    bool read_split_log_header(std::istream& s);
+    bool read_split_event(std::istream& s, split_event_t& event);
+}
+
+#endif /* SPLITLOG_H */
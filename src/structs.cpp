@@ -47,6 +47,44 @@ namespace prlearn {
         stream << ", " << _variance << "]";
     }
 
+    void qvar_t::write(std::ostream& s) const {
+        avg_t::write(s);
+        write_binary(s, &_variance);
+    }
+
+    bool qvar_t::read(std::istream& s) {
+        return avg_t::read(s) && read_binary(s, &_variance) && !std::isnan(_variance);
+    }
+
+    void splitfilter_t::write(std::ostream& s) const {
+        write_binary(s, &_vfilter);
+        write_binary(s, &_hfilter);
+        write_binary(s, &_lfilter);
+    }
+
+    bool splitfilter_t::read(std::istream& s) {
+        return read_binary(s, &_vfilter) && read_binary(s, &_hfilter) && read_binary(s, &_lfilter);
+    }
+
+    void simple_split_t::write(std::ostream& s) const {
+        write_binary(s, &_var);
+        write_binary(s, &_boundary);
+        write_binary(s, &_low);
+        write_binary(s, &_high);
+        write_binary(s, &_is_split);
+    }
+
+    bool simple_split_t::read(std::istream& s) {
+        // not straight into the bool, any byte but 0 and 1 is corrupt
+        uint8_t is_split;
+        if (!read_binary(s, &_var) || !read_binary(s, &_boundary) ||
+                !read_binary(s, &_low) || !read_binary(s, &_high) ||
+                !read_binary(s, &is_split) || is_split > 1)
+            return false;
+        _is_split = is_split == 1;
+        return true;
+    }
+
     std::ostream& operator<<(std::ostream& o, const qvar_t& v) {
         v.print(o);
         return o;
@@ -103,6 +141,127 @@ namespace prlearn {
         assert(!std::isinf(_variance));
     }
 
+    void qvar_t::addPoints(const double* values, const double* weights, size_t n) {
+        double w = 0, s = 0;
+        for (size_t i = 0; i < n; ++i) {
+            const double wi = weights ? weights[i] : 1.0;
+            w += wi;
+            s += wi * values[i];
+        }
+        if (w == 0) return;
+        const double mean = s / w;
+        double m2 = 0;
+        for (size_t i = 0; i < n; ++i) {
+            const double wi = weights ? weights[i] : 1.0;
+            const double dif = values[i] - mean;
+            m2 += wi * dif * dif;
+        }
+        merge(qvar_t(mean, w, m2 / w));
+    }
+
+    void qvar_t::merge(const qvar_t& other) {
+        assert(other._cnt >= 0);
+        if (other._cnt == 0) return;
+        if (_cnt == 0) {
+            *this = other;
+            return;
+        }
+        const double cnt = _cnt + other._cnt;
+        const double delta = other._avg - _avg;
+        const double wa = _cnt / cnt;
+        const double wb = other._cnt / cnt;
+        _avg += delta * wb;
+        _variance = (wa * _variance) + (wb * other._variance) + (delta * delta * wa * wb);
+        _cnt = cnt;
+        assert(!std::isnan(_variance));
+    }
+
+    qvar_t qvar_t::merge(const qvar_t& a, const qvar_t& b) {
+        qvar_t res = a;
+        res.merge(b);
+        return res;
+    }
+
+    qvar_t qvar_t::reduce(const qvar_t* parts, size_t n) {
+        if (n == 0) return qvar_t();
+        if (n == 1) return parts[0];
+        return merge(reduce(parts, n / 2), reduce(parts + n / 2, n - (n / 2)));
+    }
+
+    qvar_array_t::qvar_array_t(size_t n)
+    : _size(n), _data(make_pmr_array<double>(3 * n)) {
+    }
+
+    qvar_array_t::qvar_array_t(const qvar_array_t& other) {
+        *this = other;
+    }
+
+    qvar_array_t& qvar_array_t::operator=(const qvar_array_t& other) {
+        if (this == &other) return *this;
+        if (_size != other._size) {
+            auto resource = _data ? _data.get_deleter().resource() : memory::current();
+            _size = other._size;
+            _data = _size == 0 ? nullptr : make_pmr_array<double>(3 * _size, resource);
+        }
+        if (_size > 0)
+            memcpy(_data.get(), other._data.get(), 3 * _size * sizeof (double));
+        return *this;
+    }
+
+    void qvar_array_t::reset() {
+        if (_size > 0)
+            memset(_data.get(), 0, 3 * _size * sizeof (double));
+    }
+
+    void qvar_array_t::add(double value, const double* weights) {
+        double* avg = _data.get();
+        double* cnt = avg + _size;
+        double* var = cnt + _size;
+        for (size_t i = 0; i < _size; ++i) {
+            const double w = weights[i];
+            assert(w == 0 || w == 1);
+            const double c = cnt[i] + w;
+            const double div = c == 0 ? 1.0 : c;
+            // see avg_t::addPoints and qvar_t::operator+=
+            const double a = cnt[i] == 0 ? (w == 0 ? avg[i] : value) :
+                    avg[i] + (((value - avg[i]) * w) / div);
+            const double nvar = (value - a) * (value - a);
+            const double v = c == 1 ? nvar : var[i] + ((nvar - var[i]) / div);
+            avg[i] = a;
+            var[i] = w == 0 ? var[i] : v;
+            cnt[i] = c;
+        }
+    }
+
+    void qvar_array_t::merge(const qvar_array_t& other) {
+        assert(_size == other._size);
+        double* avg = _data.get();
+        double* cnt = avg + _size;
+        double* var = cnt + _size;
+        const double* oavg = other._data.get();
+        const double* ocnt = oavg + _size;
+        const double* ovar = ocnt + _size;
+        for (size_t i = 0; i < _size; ++i) {
+            // see qvar_t::merge
+            const double c = cnt[i] + ocnt[i];
+            const double div = c == 0 ? 1.0 : c;
+            const double wa = cnt[i] / div;
+            const double wb = ocnt[i] / div;
+            const double delta = oavg[i] - avg[i];
+            const double a = avg[i] + (delta * wb);
+            const double v = (wa * var[i]) + (wb * ovar[i]) + (delta * delta * wa * wb);
+            avg[i] = ocnt[i] == 0 ? avg[i] : (cnt[i] == 0 ? oavg[i] : a);
+            var[i] = ocnt[i] == 0 ? var[i] : (cnt[i] == 0 ? ovar[i] : v);
+            cnt[i] = c;
+        }
+    }
+
+    void qvar_array_t::scale(double factor) {
+        double* cnt = _data.get() + _size;
+        for (size_t i = 0; i < _size; ++i)
+            cnt[i] *= factor;
+    }
+
     double triangular_cdf(double mid, double width, double point) {
         auto cpow = std::pow(width, 2.0);
         if (point < mid)
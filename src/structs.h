@@ -33,8 +33,26 @@
 #include <cassert>
 #include <vector>
 #include <ostream>
+#include <istream>
+#include <type_traits>
+
+#include "pmr.h"
 namespace prlearn {
 
+    // native byte-order binary io, used for checkpoints
+    template<typename T>
+    inline void write_binary(std::ostream& s, const T* data, size_t n = 1) {
+        static_assert(std::is_arithmetic<T>::value, "only plain numbers");
+        s.write(reinterpret_cast<const char*> (data), n * sizeof (T));
+    }
+
+    template<typename T>
+    inline bool read_binary(std::istream& s, T* data, size_t n = 1) {
+        static_assert(std::is_arithmetic<T>::value, "only plain numbers");
+        s.read(reinterpret_cast<char*> (data), n * sizeof (T));
+        return (bool)s;
+    }
+
     struct avg_t {
         double _avg = 0;
         double _cnt = 0;
@@ -63,6 +81,31 @@ namespace prlearn {
             addPoints(1, d);
         }
 
+        // folds n points at once, weights == nullptr means unit weights.
+        inline void addPoints(const double* values, const double* weights, size_t n) {
+            double w = 0, s = 0;
+            for (size_t i = 0; i < n; ++i) {
+                const double wi = weights ? weights[i] : 1.0;
+                w += wi;
+                s += wi * values[i];
+            }
+            if (w == 0) return;
+            avg_t batch;
+            batch._cnt = w;
+            batch._avg = s / w;
+            addPoints(batch);
+        }
+
+        // pairwise reduction in a fixed order, independent of how the parts
+        // were gathered.
+        static avg_t reduce(const avg_t* parts, size_t n) {
+            if (n == 0) return avg_t();
+            if (n == 1) return parts[0];
+            auto res = reduce(parts, n / 2);
+            res.addPoints(reduce(parts + n / 2, n - (n / 2)));
+            return res;
+        }
+
         inline avg_t& operator=(const avg_t& other) {
             _avg = other._avg;
             _cnt = other._cnt;
@@ -88,6 +131,17 @@ namespace prlearn {
         bool operator!=(const avg_t& other) const {
             return _cnt != other._cnt || _avg != other._avg;
         }
+
+        void write(std::ostream& s) const {
+            write_binary(s, &_avg);
+            write_binary(s, &_cnt);
+        }
+
+        // a count is a weight, never negative; nor is an average ever NaN
+        bool read(std::istream& s) {
+            return read_binary(s, &_avg) && read_binary(s, &_cnt) && !std::isnan(_avg) &&
+                    _cnt >= 0 && std::isfinite(_cnt);
+        }
     };
 
     std::ostream& operator<<(std::ostream& stream, const avg_t& el);
@@ -104,6 +158,15 @@ namespace prlearn {
         // this is a dirty hijack!
         qvar_t& operator+=(double d);
         void addPoints(double weight, double d);
+        // folds n points at once, weights == nullptr means unit weights.
+        void addPoints(const double* values, const double* weights, size_t n);
+        // exact combination of two weighted distributions (Chan et al.),
+        // unlike approximate.
+        void merge(const qvar_t& other);
+        static qvar_t merge(const qvar_t& a, const qvar_t& b);
+        // pairwise reduction in a fixed order, independent of how the parts
+        // were gathered.
+        static qvar_t reduce(const qvar_t* parts, size_t n);
         double _variance = 0;
 
         auto& avg() {
@@ -126,9 +189,54 @@ namespace prlearn {
             return _cnt != other._cnt || _avg != other._avg;
         }
         void print(std::ostream& stream) const;
+        void write(std::ostream& s) const;
+        bool read(std::istream& s);
         static qvar_t approximate(const qvar_t& a, const qvar_t& b);
     };
 
+    // Struct-of-arrays counterpart of a qvar_t[]; averages, counts and
+    // variances are separate arrays (in a single allocation), and the bulk
+    // operations are branch-free loops over these which the compiler can
+    // vectorize.
+    class qvar_array_t {
+    public:
+        qvar_array_t() = default;
+        explicit qvar_array_t(size_t n);
+        qvar_array_t(const qvar_array_t& other);
+        qvar_array_t(qvar_array_t&&) = default;
+        qvar_array_t& operator=(const qvar_array_t& other);
+        qvar_array_t& operator=(qvar_array_t&&) = default;
+
+        size_t size() const {
+            return _size;
+        }
+
+        qvar_t get(size_t i) const {
+            assert(i < _size);
+            return qvar_t(_data[i], _data[_size + i], _data[2 * _size + i]);
+        }
+
+        void set(size_t i, const qvar_t& v) {
+            assert(i < _size);
+            _data[i] = v.avg();
+            _data[_size + i] = v.cnt();
+            _data[2 * _size + i] = v._variance;
+        }
+
+        // adds value to the elements with weight 1 (weights are 0 or 1),
+        // exactly as qvar_t::operator+= would.
+        void add(double value, const double* weights);
+        // element-wise qvar_t::merge
+        void merge(const qvar_array_t& other);
+        // scales all counts by factor
+        void scale(double factor);
+        void reset();
+
+    private:
+        size_t _size = 0;
+        pmr_array_t<double> _data = nullptr;
+    };
+
     struct splitfilter_t {
         double _vfilter = 0.0;
         double _hfilter = 0.0;
@@ -142,6 +250,8 @@ namespace prlearn {
             return std::max(_vfilter, std::max(_hfilter, _lfilter));
         }
         void add(const qvar_t&, const qvar_t&, double indif, double tl, double tu, double t2, double rate);
+        void write(std::ostream& s) const;
+        bool read(std::istream& s);
     };
 
 
@@ -153,6 +263,8 @@ namespace prlearn {
         size_t _low = 0;
         size_t _high = 0;
         bool _is_split = false;
+        void write(std::ostream& s) const;
+        bool read(std::istream& s);
     };
 
     struct el_t {
@@ -0,0 +1,109 @@
+/*
+ * Copyright Peter G. Jensen
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * File:   threadpool.cpp
+ * Author: Peter G. Jensen
+ *
+ * Created on October 17, 2026, 10:12 AM
+ */
+
+#include "threadpool.h"
+
+namespace prlearn {
+
+    threadpool_t::~threadpool_t() {
+        {
+            std::lock_guard<std::mutex> lock(_lock);
+            _stop = true;
+        }
+        _wake.notify_all();
+        for (auto& t : _threads)
+            t.join();
+    }
+
+    threadpool_t& threadpool_t::shared(size_t threads) {
+        static threadpool_t pool;
+        if (threads > pool.size())
+            pool.grow(threads - 1);
+        return pool;
+    }
+
+    void threadpool_t::grow(size_t workers) {
+        // new workers may only be added between runs, skip it when busy
+        std::unique_lock<std::mutex> busy(_busy, std::try_to_lock);
+        if (!busy.owns_lock()) return;
+        std::lock_guard<std::mutex> lock(_lock);
+        while (_threads.size() < workers)
+            _threads.emplace_back([this, generation = _generation] {
+                loop(generation);
+            });
+        _size = _threads.size();
+    }
+
+    void threadpool_t::dispatch(size_t n, std::function<void(size_t) >& task) {
+        {
+            std::lock_guard<std::mutex> lock(_lock);
+            _task = &task;
+            _n = n;
+            _next = 0;
+            _pending = _threads.size();
+            _error = nullptr;
+            ++_generation;
+        }
+        _wake.notify_all();
+        work();
+        std::unique_lock<std::mutex> lock(_lock);
+        _done.wait(lock, [this] {
+            return _pending == 0;
+        });
+        _task = nullptr;
+        if (_error)
+            std::rethrow_exception(_error);
+    }
+
+    void threadpool_t::work() {
+        for (size_t i = _next++; i < _n; i = _next++) {
+            try {
+                (*_task)(i);
+            } catch (...) {
+                std::lock_guard<std::mutex> lock(_lock);
+                if (!_error)
+                    _error = std::current_exception();
+            }
+        }
+    }
+
+    void threadpool_t::loop(size_t generation) {
+        while (true) {
+            {
+                std::unique_lock<std::mutex> lock(_lock);
+                _wake.wait(lock, [&] {
+                    return _stop || _generation != generation;
+                });
+                if (_stop) return;
+                generation = _generation;
+            }
+            work();
+            {
+                std::lock_guard<std::mutex> lock(_lock);
+                --_pending;
+            }
+            _done.notify_one();
+        }
+    }
+}
@@ -0,0 +1,93 @@
+/*
+ * Copyright Peter G. Jensen
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * File:   threadpool.h
+ * Author: Peter G. Jensen
+ *
+ * Created on October 17, 2026, 10:12 AM
+ */
+
+#ifndef THREADPOOL_H
+#define THREADPOOL_H
+
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <functional>
+#include <exception>
+#include <condition_variable>
+
+namespace prlearn {
+
+    // A minimal fork-join pool. run(n, fun) calls fun(i) for all i in [0, n)
+    // and returns when all calls have returned; the calling thread takes part.
+    // Only one run is served at a time, concurrent or nested calls execute
+    // serially in the calling thread instead of waiting.
+    class threadpool_t {
+    public:
+        threadpool_t() = default;
+        threadpool_t(const threadpool_t&) = delete;
+        threadpool_t& operator=(const threadpool_t&) = delete;
+        ~threadpool_t();
+
+        // process-wide pool with at least threads - 1 workers.
+        static threadpool_t& shared(size_t threads);
+
+        void grow(size_t workers);
+
+        size_t size() const {
+            return _size + 1;
+        }
+
+        template<typename F>
+        void run(size_t n, F&& fun) {
+            std::unique_lock<std::mutex> busy(_busy, std::try_to_lock);
+            if (!busy.owns_lock() || _size == 0 || n <= 1) {
+                for (size_t i = 0; i < n; ++i)
+                    fun(i);
+                return;
+            }
+            std::function<void(size_t) > task = [&fun](size_t i) {
+                fun(i);
+            };
+            dispatch(n, task);
+        }
+
+    private:
+        void dispatch(size_t n, std::function<void(size_t) >& task);
+        void work();
+        void loop(size_t generation);
+
+        std::mutex _busy;
+        std::mutex _lock;
+        std::condition_variable _wake, _done;
+        std::vector<std::thread> _threads;
+        std::atomic<size_t> _size{0};
+        std::function<void(size_t) >* _task = nullptr;
+        std::atomic<size_t> _next{0};
+        size_t _n = 0;
+        size_t _pending = 0;
+        size_t _generation = 0;
+        bool _stop = false;
+        std::exception_ptr _error = nullptr;
+    };
+}
+
+#endif /* THREADPOOL_H */
+
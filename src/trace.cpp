@@ -0,0 +1,149 @@
+/*
+ * Copyright Peter G. Jensen
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * File:   trace.cpp
+ * Author: Peter G. Jensen
+ *
+ * Created on October 17, 2026, 9:40 PM
+ */
+
+#include "trace.h"
+
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <vector>
+#include <iomanip>
+
+namespace prlearn {
+    namespace trace {
+
+        std::atomic<bool> _enabled{false};
+
+        namespace {
+
+            struct event_t {
+                const char* _name;
+                uint64_t _start;
+                uint64_t _end;
+            };
+
+            // only the owning thread appends; readers see the events below
+            // _size, and chunks are only added at the tail.
+            struct chunk_t {
+                static constexpr size_t capacity = 4096;
+                event_t _events[capacity];
+                std::atomic<size_t> _size{0};
+                std::atomic<chunk_t*> _next{nullptr};
+            };
+
+            struct buffer_t {
+                size_t _tid = 0;
+                chunk_t _head;
+                chunk_t* _tail = &_head;
+
+                ~buffer_t() {
+                    release();
+                }
+
+                void release() {
+                    auto c = _head._next.exchange(nullptr);
+                    while (c != nullptr) {
+                        auto n = c->_next.load();
+                        delete c;
+                        c = n;
+                    }
+                    _head._size = 0;
+                    _tail = &_head;
+                }
+            };
+
+            // the buffers are registered once per thread
+            std::mutex registry_lock;
+            std::vector<std::unique_ptr<buffer_t>>& registry() {
+                static std::vector<std::unique_ptr<buffer_t>> buffers;
+                return buffers;
+            }
+
+            thread_local buffer_t* local = nullptr;
+
+            buffer_t* local_buffer() {
+                if (local == nullptr) {
+                    std::lock_guard<std::mutex> lock(registry_lock);
+                    auto& buffers = registry();
+                    buffers.emplace_back(std::make_unique<buffer_t>());
+                    buffers.back()->_tid = buffers.size();
+                    local = buffers.back().get();
+                }
+                return local;
+            }
+        }
+
+        void enable(bool enable) {
+            _enabled.store(enable);
+        }
+
+        uint64_t now() {
+            return std::chrono::duration_cast<std::chrono::nanoseconds>(
+                    std::chrono::steady_clock::now().time_since_epoch()).count();
+        }
+
+        void record(const char* name, uint64_t start, uint64_t end) {
+            auto buffer = local_buffer();
+            auto chunk = buffer->_tail;
+            auto n = chunk->_size.load(std::memory_order_relaxed);
+            if (n == chunk_t::capacity) {
+                auto next = new chunk_t;
+                chunk->_next.store(next, std::memory_order_release);
+                buffer->_tail = chunk = next;
+                n = 0;
+            }
+            chunk->_events[n] = event_t{name, start, end};
+            chunk->_size.store(n + 1, std::memory_order_release);
+        }
+
+        void write_chrome_json(std::ostream& s) {
+            std::lock_guard<std::mutex> lock(registry_lock);
+            auto flags = s.flags();
+            auto precision = s.precision();
+            s << std::fixed << std::setprecision(3) << "{\"traceEvents\":[";
+            bool first = true;
+            for (auto& b : registry()) {
+                for (const chunk_t* c = &b->_head; c != nullptr; c = c->_next.load(std::memory_order_acquire)) {
+                    const auto n = c->_size.load(std::memory_order_acquire);
+                    for (size_t i = 0; i < n; ++i) {
+                        auto& e = c->_events[i];
+                        s << (first ? "\n" : ",\n") << "{\"name\":\"" << e._name << "\",\"ph\":\"X\",\"pid\":1,\"tid\":"
+                                << b->_tid << ",\"ts\":" << (e._start / 1000.0) << ",\"dur\":"
+                                << ((e._end - e._start) / 1000.0) << "}";
+                        first = false;
+                    }
+                }
+            }
+            s << "\n],\"displayTimeUnit\":\"ns\"}\n";
+            s.flags(flags);
+            s.precision(precision);
+        }
+
+        void clear() {
+            std::lock_guard<std::mutex> lock(registry_lock);
+            for (auto& b : registry())
+                b->release();
+        }
+    }
+}
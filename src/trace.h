@@ -0,0 +1,88 @@
+/*
+ * Copyright Peter G. Jensen
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * File:   trace.h
+ * Author: Peter G. Jensen
+ *
+ * Created on October 17, 2026, 9:40 PM
+ */
+
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <atomic>
+#include <cstdint>
+#include <ostream>
+
+namespace prlearn {
+
+    // Scoped spans of the learning phases, written as Chrome trace-events
+    // (chrome://tracing or Perfetto). Nothing is recorded until enabled; a
+    // span then costs a relaxed load and a branch. Building with
+    // PRLEARN_NO_TRACE removes the spans altogether.
+    // Every thread records into its own buffer without locking; buffers are
+    // kept until clear(), also after their thread has ended.
+    namespace trace {
+        extern std::atomic<bool> _enabled;
+
+        inline bool enabled() {
+            return _enabled.load(std::memory_order_relaxed);
+        }
+
+        void enable(bool enable);
+        // nanoseconds, steady clock
+        uint64_t now();
+        // name must outlive the trace, e.g. a literal
+        void record(const char* name, uint64_t start, uint64_t end);
+
+        // the spans recorded so far, from all threads; may be called while
+        // recording, spans recorded meanwhile may be left out.
+        void write_chrome_json(std::ostream& s);
+        // drops all spans; only while nothing is being recorded.
+        void clear();
+
+        class span_t {
+        public:
+
+            explicit span_t(const char* name)
+            : _name(enabled() ? name : nullptr), _start(_name != nullptr ? now() : 0) {
+            }
+
+            ~span_t() {
+                if (_name != nullptr)
+                    record(_name, _start, now());
+            }
+
+            span_t(const span_t&) = delete;
+            span_t& operator=(const span_t&) = delete;
+        private:
+            const char* _name;
+            uint64_t _start;
+        };
+    }
+}
+
+#define PRLEARN_TRACE_CAT2(a, b) a##b
+#define PRLEARN_TRACE_CAT(a, b) PRLEARN_TRACE_CAT2(a, b)
+#if defined(PRLEARN_NO_TRACE)
+#define PRLEARN_TRACE_SPAN(name) ((void) 0)
+#else
+#define PRLEARN_TRACE_SPAN(name) prlearn::trace::span_t PRLEARN_TRACE_CAT(_prlearn_span_, __LINE__)(name)
+#endif
+
+#endif /* TRACE_H */
@@ -0,0 +1,111 @@
+/*
+ * Copyright Peter G. Jensen
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * File:   histogram.h
+ * Author: Peter G. Jensen
+ *
+ * Created on October 18, 2026, 2:15 PM
+ */
+
+#ifndef TOOLS_HISTOGRAM_H
+#define TOOLS_HISTOGRAM_H
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <ostream>
+
+namespace prlearn {
+    namespace tools {
+
+        // Log-linear histogram of non-negative integers (latencies in ns);
+        // 16 buckets per power of two, so within about 6% of the value.
+        // Safe to add to from several threads.
+        class histogram_t {
+        public:
+            void add(uint64_t value) {
+                _counts[bucket(value)].fetch_add(1, std::memory_order_relaxed);
+                _count.fetch_add(1, std::memory_order_relaxed);
+                _sum.fetch_add(value, std::memory_order_relaxed);
+                auto max = _max.load(std::memory_order_relaxed);
+                while (value > max && !_max.compare_exchange_weak(max, value, std::memory_order_relaxed));
+            }
+
+            uint64_t count() const {
+                return _count.load(std::memory_order_relaxed);
+            }
+
+            double mean() const {
+                auto n = count();
+                return n > 0 ? (double) _sum.load(std::memory_order_relaxed) / n : 0;
+            }
+
+            uint64_t max() const {
+                return _max.load(std::memory_order_relaxed);
+            }
+
+            // the upper bound of the bucket holding the p'th value
+            uint64_t percentile(double p) const {
+                const auto n = count();
+                if (n == 0) return 0;
+                uint64_t rank = (uint64_t) (p * n), seen = 0;
+                for (size_t b = 0; b < buckets; ++b) {
+                    seen += _counts[b].load(std::memory_order_relaxed);
+                    if (seen > rank)
+                        return std::min(upper(b), max());
+                }
+                return max();
+            }
+
+            // the non-empty buckets, one per line
+            void print(std::ostream& s) const {
+                for (size_t b = 0; b < buckets; ++b) {
+                    auto c = _counts[b].load(std::memory_order_relaxed);
+                    if (c > 0)
+                        s << "\t<= " << upper(b) << "\t" << c << "\n";
+                }
+            }
+
+        private:
+            static constexpr size_t sub_bits = 4;
+            static constexpr size_t buckets = (64 - sub_bits + 1) << sub_bits;
+
+            static size_t bucket(uint64_t v) {
+                if (v < (1u << sub_bits))
+                    return v;
+                size_t msb = 63;
+                while ((v >> msb) == 0) --msb;
+                const size_t shift = msb - sub_bits;
+                return ((shift + 1) << sub_bits) + ((v >> shift) & ((1u << sub_bits) - 1));
+            }
+
+            static uint64_t upper(size_t b) {
+                if (b < (1u << sub_bits))
+                    return b;
+                const size_t shift = (b >> sub_bits) - 1;
+                const uint64_t base = ((uint64_t) 1 << sub_bits) | (b & ((1u << sub_bits) - 1));
+                return ((base + 1) << shift) - 1;
+            }
+
+            std::atomic<uint64_t> _counts[buckets] = {};
+            std::atomic<uint64_t> _count{0}, _sum{0}, _max{0};
+        };
+    }
+}
+
+#endif /* TOOLS_HISTOGRAM_H */
@@ -0,0 +1,180 @@
+/*
+ * Copyright Peter G. Jensen
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * File:   replay.cpp
+ * Author: Peter G. Jensen
+ *
+ * Created on October 18, 2026, 11:30 AM
+ */
+
+#include "MLearning.h"
+#include "SimpleMLearning.h"
+#include "QLearning.h"
+#include "RefinementTree.h"
+#include "SimpleRegressor.h"
+#include "checkpoint.h"
+#include "replay.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <type_traits>
+
+using namespace prlearn;
+
+struct settings_t {
+    std::string _learner = "MLearning";
+    std::string _log, _checkpoint, _resume;
+    size_t _repeat = 1;
+    replay_options_t _options;
+};
+
+static void usage(const char* name) {
+    std::cerr << "usage: " << name << " [options] <log>\n"
+            << "Replays a log of recorded samples (see recorder.h) into fresh clouds\n"
+            << "as fast as possible and reports the throughput.\n"
+            << "\n"
+            << "  --learner <name>     QRefinementTree, QSimpleRegressor, MLearning or\n"
+            << "                       SimpleMLearning (default MLearning)\n"
+            << "  --seed <n>           seed of the ties broken at random (default the\n"
+            << "                       one stored in the log)\n"
+            << "  --threads <n>        threads of the split-tests (default as recorded)\n"
+            << "  --limit <n>          replay at most n samples\n"
+            << "  --max-clouds <n>     stop at a sample of a cloud (or dest) from n on\n"
+            << "                       (default 65536)\n"
+            << "  --repeat <n>         replays, each into fresh clouds (default 1)\n"
+            << "  --prefetch           decode the log ahead on a second thread\n"
+            << "                       (default with more than one core)\n"
+            << "  --no-prefetch        decode the log on the replaying thread\n"
+            << "  --resume <file>      replay onto a checkpoint instead of fresh clouds\n"
+            << "  --checkpoint <file>  write the resulting clouds, see checkpoint.h\n"
+            << "                       (MLearning and SimpleMLearning)\n";
+}
+
+template<typename Learner>
+static int replay(const settings_t& s) {
+    constexpr bool checkpoints = std::is_same<Learner, MLearning>::value || std::is_same<Learner, SimpleMLearning>::value;
+    double best = 0;
+    for (size_t r = 0; r < std::max<size_t>(1, s._repeat); ++r) {
+        std::vector<Learner> clouds;
+        if constexpr (checkpoints) {
+            if (!s._resume.empty()) {
+                std::ifstream in(s._resume, std::ios::binary);
+                if (!read_checkpoint(in, clouds)) {
+                    std::cerr << "could not resume from " << s._resume << std::endl;
+                    return 1;
+                }
+            }
+        }
+        std::ifstream in(s._log, std::ios::binary);
+        if (!in) {
+            std::cerr << "could not open " << s._log << std::endl;
+            return 1;
+        }
+        replay_stats_t stats;
+        if (!replay(in, clouds, stats, s._options)) {
+            std::cerr << s._log << ": not a log of recorded samples" << std::endl;
+            return 1;
+        }
+        if (stats._beyond_max_clouds) {
+            std::cerr << s._log << ": sample " << (stats._samples + 1) << " is of a cloud beyond "
+                    << s._options._max_clouds << " (--max-clouds)" << std::endl;
+            return 1;
+        }
+        size_t nodes = 0;
+        for (auto& c : clouds) nodes += c.size();
+        best = std::max(best, stats.samples_per_sec());
+        std::cout << s._learner << ": " << stats._samples << " samples in " << stats._seconds << " s ("
+                << stats.samples_per_sec() << "/s), " << clouds.size() << " clouds, " << nodes << " nodes"
+                << (stats._truncated ? ", log truncated" : "") << std::endl;
+        if constexpr (checkpoints) {
+            if (!s._checkpoint.empty() && r + 1 == std::max<size_t>(1, s._repeat)) {
+                std::ofstream out(s._checkpoint, std::ios::binary | std::ios::trunc);
+                write_checkpoint(out, clouds);
+                if (!out.flush()) {
+                    std::cerr << "could not write " << s._checkpoint << std::endl;
+                    return 1;
+                }
+            }
+        }
+    }
+    if (s._repeat > 1)
+        std::cout << "best: " << best << "/s" << std::endl;
+    return 0;
+}
+
+int main(int argc, char** argv) {
+    settings_t s;
+    for (int i = 1; i < argc; ++i) {
+        auto arg = argv[i];
+        const bool has_value = i + 1 < argc;
+        bool ok = true;
+        if (strcmp(arg, "--learner") == 0 && has_value)
+            s._learner = argv[++i];
+        else if (strcmp(arg, "--seed") == 0 && has_value)
+            s._options._seed = std::strtoul(argv[++i], nullptr, 10);
+        else if (strcmp(arg, "--threads") == 0 && has_value)
+            s._options._threads = std::strtoull(argv[++i], nullptr, 10);
+        else if (strcmp(arg, "--limit") == 0 && has_value)
+            s._options._limit = std::strtoull(argv[++i], nullptr, 10);
+        else if (strcmp(arg, "--max-clouds") == 0 && has_value)
+            ok = (s._options._max_clouds = std::strtoull(argv[++i], nullptr, 10)) > 0;
+        else if (strcmp(arg, "--repeat") == 0 && has_value)
+            s._repeat = std::strtoull(argv[++i], nullptr, 10);
+        else if (strcmp(arg, "--prefetch") == 0)
+            s._options._prefetch = true;
+        else if (strcmp(arg, "--no-prefetch") == 0)
+            s._options._prefetch = false;
+        else if (strcmp(arg, "--resume") == 0 && has_value)
+            s._resume = argv[++i];
+        else if (strcmp(arg, "--checkpoint") == 0 && has_value)
+            s._checkpoint = argv[++i];
+        else if (arg[0] != '-' && s._log.empty())
+            s._log = arg;
+        else
+            ok = false;
+        if (!ok) {
+            usage(argv[0]);
+            return strcmp(arg, "--help") == 0 ? 0 : 1;
+        }
+    }
+    if (s._log.empty()) {
+        usage(argv[0]);
+        return 1;
+    }
+    const bool m_learner = s._learner == "MLearning" || s._learner == "SimpleMLearning";
+    if (!m_learner && s._learner != "QRefinementTree" && s._learner != "QSimpleRegressor") {
+        std::cerr << "unknown learner " << s._learner << std::endl;
+        return 1;
+    }
+    if (!m_learner && (!s._checkpoint.empty() || !s._resume.empty())) {
+        std::cerr << s._learner << " has no checkpoints" << std::endl;
+        return 1;
+    }
+
+    if (s._learner == "QRefinementTree")
+        return replay<QLearning<RefinementTree>>(s);
+    else if (s._learner == "QSimpleRegressor")
+        return replay<QLearning<SimpleRegressor>>(s);
+    else if (s._learner == "MLearning")
+        return replay<MLearning>(s);
+    else
+        return replay<SimpleMLearning>(s);
+}
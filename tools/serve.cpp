@@ -0,0 +1,771 @@
+/*
+ * Copyright Peter G. Jensen
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * File:   serve.cpp
+ * Author: Peter G. Jensen
+ *
+ * Created on October 18, 2026, 2:15 PM
+ */
+
+#include "histogram.h"
+
+#include "MLearning.h"
+#include "SimpleMLearning.h"
+#include "QLearning.h"
+#include "RefinementTree.h"
+#include "SimpleRegressor.h"
+#include "checkpoint.h"
+#include "handle.h"
+#include "pmr.h"
+#include "replay.h"
+#include "threadpool.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cmath>
+#include <condition_variable>
+#include <csignal>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <sstream>
+#include <thread>
+#include <type_traits>
+
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+using namespace prlearn;
+using namespace prlearn::tools;
+
+using steady = std::chrono::steady_clock;
+
+struct settings_t {
+    std::string _learner = "MLearning";
+    std::string _socket = "/tmp/prlearn.sock";
+    std::string _model; // of --checkpoint or --log
+    bool _live = false;
+    bool _minimization = true;
+    double _delta = 1;
+    size_t _labels = 0;
+    size_t _threads = 1;
+    // samples may create clouds up to this id
+    size_t _max_clouds = 1 << 16;
+    propts_t _options;
+};
+
+static void usage(const char* name) {
+    std::cerr << "usage: " << name << " [options]\n"
+            << "Serves the lookups of a model on a Unix domain socket; one request\n"
+            << "per line, answered in order with a line starting with ok or error.\n"
+            << "States and labels are comma-separated, * is all labels.\n"
+            << "\n"
+            << "  lookup <cloud> <label> <state>        ok <value> <count> <variance>\n"
+            << "  best <cloud> <state> [<labels>]       ok <label> <value>, or ok none\n"
+            << "  sample <cloud> <state> <label> <dest> <next-state> <next-labels> <cost>\n"
+            << "                                        ok; trains the model (--live)\n"
+            << "  reload <file>                         ok <version>; serves a checkpoint or\n"
+            << "                                        a log instead, from the next request\n"
+            << "  stats                                 ok <latencies and batch sizes>\n"
+            << "\n"
+            << "  --learner <name>     QRefinementTree, QSimpleRegressor, MLearning or\n"
+            << "                       SimpleMLearning (default MLearning)\n"
+            << "  --checkpoint <file>  load the model from a checkpoint, see checkpoint.h\n"
+            << "  --log <file>         build the model by replaying recorded samples,\n"
+            << "                       see recorder.h\n"
+            << "  --live               accept samples; otherwise the model is frozen\n"
+            << "  --max-clouds <n>     samples (also in logs) of clouds or destinations\n"
+            << "                       from n on are rejected (default 65536)\n"
+            << "  --socket <path>      (default /tmp/prlearn.sock)\n"
+            << "  --labels <n>         the labels of best without labels are 0..n-1\n"
+            << "                       (default the labels seen per cloud)\n"
+            << "  --threads <n>        threads for the lookups of large batches\n"
+            << "  --maximize           best maximizes, samples maximize the value\n"
+            << "  --discount <d>       of the samples (default 0.99)\n"
+            << "  --delta <d>          of the samples (default 1)\n"
+            << "  --split-decay <w>    of the samples, in (0, 1] or 0 (default 0)\n";
+}
+
+enum kind_t {
+    LOOKUP, BEST, SAMPLE, RELOAD, STATS, ERROR
+};
+
+struct request_t {
+    kind_t _kind = ERROR;
+    size_t _cloud = 0;
+    size_t _label = 0;
+    size_t _dest = 0;
+    std::vector<double> _point, _next_point;
+    // of best and the next-labels of samples
+    bool _all_labels = true;
+    std::vector<size_t> _labels;
+    double _cost = 0;
+    // of reload, the file and the model_t loaded from it
+    std::string _file;
+    std::shared_ptr<void> _model;
+    steady::time_point _arrival;
+    // the answer
+    qvar_t _q;
+    bool _found = false;
+    uint64_t _version = 0;
+    std::string _error;
+};
+
+// the requests read from a connection in one go
+struct group_t {
+    std::vector<request_t> _requests;
+    bool _done = false;
+};
+
+template<typename T>
+static bool parse_list(const std::string& token, std::vector<T>& values) {
+    values.clear();
+    const char* p = token.c_str();
+    while (*p != 0) {
+        char* end;
+        if (std::is_floating_point<T>::value)
+            values.push_back(std::strtod(p, &end));
+        else {
+            if (*p == '-') return false;
+            values.push_back(std::strtoull(p, &end, 10));
+        }
+        if (end == p) return false;
+        p = end;
+        if (*p == ',') ++p;
+        else if (*p != 0) return false;
+    }
+    return !values.empty();
+}
+
+static bool parse_number(const std::string& token, size_t& value) {
+    std::vector<size_t> v;
+    if (!parse_list(token, v) || v.size() != 1)
+        return false;
+    value = v[0];
+    return true;
+}
+
+static bool parse_labels(const std::string& token, request_t& r) {
+    r._all_labels = token == "*";
+    return r._all_labels || parse_list(token, r._labels);
+}
+
+static request_t parse(const std::string& line, const settings_t& settings) {
+    request_t r;
+    r._arrival = steady::now();
+    std::istringstream in(line);
+    std::vector<std::string> t;
+    for (std::string token; in >> token;)
+        t.push_back(token);
+    bool ok = false;
+    if (t.empty())
+        r._error = "empty request";
+    else if (t[0] == "lookup") {
+        r._kind = LOOKUP;
+        ok = t.size() == 4 && parse_number(t[1], r._cloud) && parse_number(t[2], r._label) &&
+                parse_list(t[3], r._point);
+    } else if (t[0] == "best") {
+        r._kind = BEST;
+        ok = (t.size() == 3 || t.size() == 4) && parse_number(t[1], r._cloud) && parse_list(t[2], r._point) &&
+                (t.size() == 3 || parse_labels(t[3], r));
+    } else if (t[0] == "sample") {
+        r._kind = SAMPLE;
+        std::vector<double> cost;
+        ok = t.size() == 8 && parse_number(t[1], r._cloud) && parse_list(t[2], r._point) &&
+                parse_number(t[3], r._label) && parse_number(t[4], r._dest) && parse_list(t[5], r._next_point) &&
+                parse_labels(t[6], r) && parse_list(t[7], cost) && cost.size() == 1 &&
+                r._point.size() == r._next_point.size();
+        r._cost = cost.empty() ? 0 : cost[0];
+        if (ok && !settings._live) {
+            r._kind = ERROR;
+            r._error = "the model is frozen";
+            return r;
+        }
+        // train grows the model to the clouds named
+        if (ok && (r._cloud >= settings._max_clouds || r._dest >= settings._max_clouds)) {
+            r._kind = ERROR;
+            r._error = "clouds are limited to " + std::to_string(settings._max_clouds) + " (--max-clouds)";
+            return r;
+        }
+    } else if (t[0] == "reload") {
+        r._kind = RELOAD;
+        ok = t.size() == 2;
+        if (ok) r._file = t[1];
+    } else if (t[0] == "stats") {
+        r._kind = STATS;
+        ok = t.size() == 1;
+    } else
+        r._error = "unknown request " + t[0];
+    if (!ok) {
+        if (r._error.empty())
+            r._error = "malformed " + t[0];
+        r._kind = ERROR;
+    }
+    return r;
+}
+
+template<typename Learner>
+struct model_t {
+    std::vector<Learner> _clouds;
+    size_t _dimen = 0; // 0 if not known
+    std::vector<std::set<size_t>> _labels; // seen, per cloud
+};
+
+// A model is loaded on a connection, trained on the worker and freed on the
+// main thread, so it lives on the global heap rather than in whatever
+// resource (pmr.h) the loading thread has current.
+static std::pmr::memory_resource* model_resource() {
+    return std::pmr::new_delete_resource();
+}
+
+// A log of recorded samples (see recorder.h) or a checkpoint (see
+// checkpoint.h), whichever the file is.
+template<typename Learner>
+static bool load(const std::string& file, model_t<Learner>& model, size_t max_clouds, std::string& error) {
+    memory::scope_t scope(model_resource());
+    std::ifstream in(file, std::ios::binary);
+    if (!in) {
+        error = "could not open " + file;
+        return false;
+    }
+    replay_stats_t stats;
+    replay_options_t options;
+    options._max_clouds = max_clouds;
+    if (replay(in, model._clouds, stats, options)) {
+        if (stats._beyond_max_clouds) {
+            error = file + ": clouds are limited to " + std::to_string(max_clouds) + " (--max-clouds)";
+            return false;
+        }
+        // the labels and dimension, from a second pass
+        in.clear();
+        in.seekg(0);
+        sample_reader_t reader(in);
+        sample_t sample;
+        while (reader.next(sample)) {
+            if (model._labels.size() <= sample._location)
+                model._labels.resize(sample._location + 1);
+            model._labels[sample._location].insert(sample._label);
+            model._dimen = sample._dimen;
+        }
+        return true;
+    }
+    if constexpr (std::is_same<Learner, MLearning>::value || std::is_same<Learner, SimpleMLearning>::value) {
+        in.clear();
+        in.seekg(0);
+        model._clouds.clear();
+        if (read_checkpoint(in, model._clouds)) {
+            if constexpr (std::is_same<Learner, MLearning>::value) {
+                for (auto& c : model._clouds)
+                    model._dimen = std::max(model._dimen, c.dimen());
+            }
+            model._labels.resize(model._clouds.size());
+            for (size_t c = 0; c < model._clouds.size(); ++c) {
+                auto labels = model._clouds[c].labels();
+                model._labels[c].insert(labels.begin(), labels.end());
+            }
+            return true;
+        }
+        error = file + ": neither a log of recorded samples nor a checkpoint";
+    } else
+        error = file + ": not a log of recorded samples";
+    return false;
+}
+
+template<typename Learner>
+class server_t {
+public:
+    using model_ptr = std::shared_ptr<model_t<Learner>>;
+
+    server_t(model_ptr model, const settings_t& settings)
+    : _model(model), _live(std::move(model)), _settings(settings) {
+        for (size_t l = 0; l < _settings._labels; ++l)
+            _all.insert(l);
+        _worker = std::thread([this] {
+            work();
+        });
+    }
+
+    ~server_t() {
+        {
+            std::lock_guard<std::mutex> lock(_lock);
+            _stop = true;
+        }
+        _wake.notify_all();
+        _worker.join();
+    }
+
+    // returns when all requests of the group are answered
+    void submit(group_t& group) {
+        std::unique_lock<std::mutex> lock(_lock);
+        _queue.push_back(&group);
+        _wake.notify_one();
+        _answered.wait(lock, [&group] {
+            return group._done;
+        });
+    }
+
+    // frees the models replaced by reload; off the worker, which then
+    // never pays for it.
+    size_t reclaim() {
+        return _model.reclaim();
+    }
+
+    uint64_t version() const {
+        return _model.version();
+    }
+
+    histogram_t _latency[3]; // by kind, in ns
+    histogram_t _batches; // requests per batch
+
+private:
+
+    void work() {
+        std::vector<group_t*> groups;
+        while (true) {
+            {
+                std::unique_lock<std::mutex> lock(_lock);
+                _wake.wait(lock, [this] {
+                    return _stop || !_queue.empty();
+                });
+                if (_stop) return;
+                // everything waiting is answered together
+                groups.swap(_queue);
+            }
+            evaluate(groups);
+            {
+                std::lock_guard<std::mutex> lock(_lock);
+                for (auto g : groups)
+                    g->_done = true;
+            }
+            _answered.notify_all();
+            groups.clear();
+        }
+    }
+
+    const std::set<size_t>& labels_of(const model_t<Learner>& model, size_t cloud) const {
+        static const std::set<size_t> none;
+        if (!_all.empty())
+            return _all;
+        return cloud < model._labels.size() ? model._labels[cloud] : none;
+    }
+
+    static bool check(const model_t<Learner>& model, request_t& r) {
+        if (model._dimen != 0 && r._point.size() != model._dimen) {
+            r._error = "expected a state of dimension " + std::to_string(model._dimen);
+            return false;
+        }
+        return true;
+    }
+
+    // Answers the requests as if one by one, in order; the lookups between
+    // two samples or reloads (all of them for a frozen model) are answered
+    // together.
+    void evaluate(std::vector<group_t*>& groups) {
+        std::vector<request_t*> pending;
+        size_t n = 0;
+        for (auto g : groups) {
+            for (auto& r : g->_requests) {
+                ++n;
+                if (r._kind == LOOKUP || r._kind == BEST)
+                    pending.push_back(&r);
+                else if ((r._kind == SAMPLE || r._kind == RELOAD) && r._error.empty()) {
+                    answer(pending);
+                    pending.clear();
+                    if (r._kind == SAMPLE)
+                        train(r);
+                    else
+                        reload(r);
+                }
+            }
+        }
+        answer(pending);
+        _batches.add(n);
+    }
+
+    // One traversal per (request, label). The traversals are sorted by
+    // cloud, label and state, so consecutive ones share the top of their
+    // tree and mostly their path; large batches are split over the pool.
+    void answer(const std::vector<request_t*>& requests) {
+        if (requests.empty()) return;
+        // all of the batch on the same model, even if replaced meanwhile
+        const auto model = _model.acquire();
+        struct item_t {
+            size_t _cloud, _label;
+            const double* _point;
+            size_t _dimen;
+            size_t _out;
+        };
+        std::vector<item_t> items;
+        // request, (first) value
+        std::vector<std::pair<request_t*, size_t>> lookups, best;
+        for (auto r : requests) {
+            if (!check(*model, *r)) continue;
+            if (r->_kind == LOOKUP) {
+                lookups.emplace_back(r, items.size());
+                items.push_back(item_t{r->_cloud, r->_label, r->_point.data(), r->_point.size(), items.size()});
+            } else {
+                best.emplace_back(r, items.size());
+                if (r->_all_labels) {
+                    auto& all = labels_of(*model, r->_cloud);
+                    r->_labels.assign(all.begin(), all.end());
+                }
+                for (auto l : r->_labels)
+                    items.push_back(item_t{r->_cloud, l, r->_point.data(), r->_point.size(), items.size()});
+            }
+        }
+        if (items.empty()) return;
+
+        std::vector<qvar_t> values(items.size());
+        std::sort(items.begin(), items.end(), [](const item_t& a, const item_t& b) {
+            if (a._cloud != b._cloud) return a._cloud < b._cloud;
+            if (a._label != b._label) return a._label < b._label;
+            return std::lexicographical_compare(a._point, a._point + a._dimen, b._point, b._point + b._dimen);
+        });
+        auto& clouds = model->_clouds;
+        auto lookup = [&clouds, &items, &values](size_t begin, size_t end) {
+            for (size_t i = begin; i < end; ++i) {
+                auto& it = items[i];
+                values[it._out] = it._cloud < clouds.size() ?
+                        clouds[it._cloud].lookup(it._label, it._point, it._dimen) :
+                        qvar_t(std::numeric_limits<double>::quiet_NaN(), 0, 0);
+            }
+        };
+        constexpr size_t chunk = 512;
+        if (_settings._threads > 1 && items.size() >= 2 * chunk) {
+            threadpool_t::shared(_settings._threads).run((items.size() + chunk - 1) / chunk, [&](size_t c) {
+                lookup(c * chunk, std::min(items.size(), (c + 1) * chunk));
+            });
+        } else
+            lookup(0, items.size());
+
+        for (auto& [r, i] : lookups)
+            r->_q = values[i];
+        for (auto& [r, first] : best) {
+            double val = _settings._minimization ? std::numeric_limits<double>::infinity() : -std::numeric_limits<double>::infinity();
+            for (size_t i = 0; i < r->_labels.size(); ++i) {
+                auto v = values[first + i].avg();
+                if (std::isinf(v) || std::isnan(v)) continue;
+                if (!r->_found || (_settings._minimization ? v < val : v > val)) {
+                    val = v;
+                    r->_label = r->_labels[i];
+                    r->_found = true;
+                }
+            }
+            r->_q = qvar_t(val, 0, 0);
+        }
+    }
+
+    // in place; _live is the published model, only the worker reads it
+    void train(request_t& r) {
+        auto& m = *_live;
+        if (!check(m, r)) return;
+        if (m._dimen == 0)
+            m._dimen = r._point.size();
+        const size_t clouds = std::max(r._cloud, r._dest) + 1;
+        if (m._clouds.size() < clouds) {
+            memory::scope_t scope(model_resource());
+            m._clouds.resize(clouds);
+        }
+        m._labels.resize(std::max(m._labels.size(), clouds));
+        m._labels[r._cloud].insert(r._label);
+        m._clouds[r._cloud].addSample(r._point.size(), r._point.data(), r._next_point.data(),
+                r._all_labels ? nullptr : r._labels.data(), r._labels.size(), r._label, r._dest, r._cost,
+                m._clouds, _settings._minimization, _settings._delta, _settings._options);
+    }
+
+    // the model was loaded by the connection
+    void reload(request_t& r) {
+        _live = std::static_pointer_cast<model_t<Learner>>(std::move(r._model));
+        r._version = _model.swap(_live);
+    }
+
+    model_handle_t<model_t<Learner>> _model;
+    model_ptr _live;
+    std::set<size_t> _all; // of --labels
+    const settings_t& _settings;
+    std::mutex _lock;
+    std::condition_variable _wake, _answered;
+    std::vector<group_t*> _queue;
+    bool _stop = false;
+    std::thread _worker;
+};
+
+static void print_latency(std::ostream& s, const char* name, const histogram_t& h) {
+    s << name << " n=" << h.count() << std::fixed << std::setprecision(1)
+            << " mean=" << h.mean() / 1000 << "us p50=" << h.percentile(0.5) / 1000.0
+            << "us p90=" << h.percentile(0.9) / 1000.0 << "us p99=" << h.percentile(0.99) / 1000.0
+            << "us max=" << h.max() / 1000.0 << "us" << std::defaultfloat;
+}
+
+template<typename Learner>
+static void print_stats(std::ostream& s, server_t<Learner>& server) {
+    print_latency(s, "lookup", server._latency[LOOKUP]);
+    print_latency(s, "; best", server._latency[BEST]);
+    print_latency(s, "; sample", server._latency[SAMPLE]);
+    s << "; batch n=" << server._batches.count() << std::fixed << std::setprecision(1)
+            << " mean=" << server._batches.mean() << std::defaultfloat
+            << " p50=" << server._batches.percentile(0.5) << " max=" << server._batches.max()
+            << "; model version=" << server.version() << " retired=" << server.reclaim();
+}
+
+static bool write_all(int fd, const std::string& data) {
+    size_t done = 0;
+    while (done < data.size()) {
+        auto n = ::write(fd, data.data() + done, data.size() - done);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) return false;
+        done += n;
+    }
+    return true;
+}
+
+template<typename Learner>
+static void connection(int fd, server_t<Learner>& server, const settings_t& settings) {
+    std::string buffer;
+    char chunk[1 << 16];
+    while (true) {
+        auto n = ::read(fd, chunk, sizeof (chunk));
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) break;
+        buffer.append(chunk, n);
+        // all complete lines go in a single group
+        group_t group;
+        size_t start = 0;
+        for (size_t nl; (nl = buffer.find('\n', start)) != std::string::npos; start = nl + 1) {
+            auto line = buffer.substr(start, nl - start);
+            if (!line.empty() && line.back() == '\r') line.pop_back();
+            group._requests.push_back(parse(line, settings));
+        }
+        buffer.erase(0, start);
+        if (group._requests.empty()) continue;
+        // loaded here, so the others are served meanwhile
+        for (auto& r : group._requests) {
+            if (r._kind != RELOAD || !r._error.empty()) continue;
+            auto model = std::make_shared<model_t<Learner>>();
+            if (load(r._file, *model, settings._max_clouds, r._error))
+                r._model = std::move(model);
+        }
+        server.submit(group);
+
+        std::ostringstream out;
+        out << std::setprecision(std::numeric_limits<double>::digits10 + 1);
+        const auto now = steady::now();
+        for (auto& r : group._requests) {
+            if (!r._error.empty()) {
+                out << "error " << r._error << "\n";
+                continue;
+            }
+            switch (r._kind) {
+                case LOOKUP:
+                    out << "ok " << r._q.avg() << " " << r._q.cnt() << " " << r._q._variance << "\n";
+                    break;
+                case BEST:
+                    if (r._found) out << "ok " << r._label << " " << r._q.avg() << "\n";
+                    else out << "ok none\n";
+                    break;
+                case SAMPLE:
+                    out << "ok\n";
+                    break;
+                case RELOAD:
+                    out << "ok " << r._version << "\n";
+                    continue;
+                default:
+                {
+                    // in a stream of its own, for the precision
+                    std::ostringstream stats;
+                    print_stats(stats, server);
+                    out << "ok " << stats.str() << "\n";
+                    continue;
+                }
+            }
+            server._latency[r._kind].add(std::chrono::duration_cast<std::chrono::nanoseconds>(now - r._arrival).count());
+        }
+        if (!write_all(fd, out.str()))
+            break;
+    }
+    ::close(fd);
+}
+
+static volatile std::sig_atomic_t stopped = 0;
+
+static void stop(int) {
+    stopped = 1;
+}
+
+struct client_t {
+    int _fd;
+    std::thread _thread;
+    std::atomic<bool> _done{false};
+};
+
+template<typename Learner>
+static int serve(const settings_t& s) {
+    auto model = std::make_shared<model_t<Learner>>();
+    if (!s._model.empty()) {
+        std::string error;
+        if (!load(s._model, *model, s._max_clouds, error)) {
+            std::cerr << error << std::endl;
+            return 1;
+        }
+        std::cerr << "loaded " << model->_clouds.size() << " clouds from " << s._model << std::endl;
+    }
+
+    int listener = ::socket(AF_UNIX, SOCK_STREAM, 0);
+    sockaddr_un address;
+    std::memset(&address, 0, sizeof (address));
+    address.sun_family = AF_UNIX;
+    if (listener < 0 || s._socket.size() >= sizeof (address.sun_path)) {
+        std::cerr << "could not create the socket " << s._socket << std::endl;
+        return 1;
+    }
+    std::strcpy(address.sun_path, s._socket.c_str());
+    ::unlink(s._socket.c_str());
+    if (::bind(listener, (sockaddr*) & address, sizeof (address)) != 0 || ::listen(listener, 128) != 0) {
+        std::cerr << "could not listen on " << s._socket << ": " << std::strerror(errno) << std::endl;
+        ::close(listener);
+        return 1;
+    }
+    std::signal(SIGPIPE, SIG_IGN);
+    std::signal(SIGINT, stop);
+    std::signal(SIGTERM, stop);
+    std::cerr << "serving " << s._learner << (s._live ? " (live)" : " (frozen)") << " on " << s._socket << std::endl;
+
+    {
+        server_t<Learner> server(std::move(model), s);
+        std::list<std::unique_ptr<client_t>> clients;
+        while (!stopped) {
+            pollfd p{listener, POLLIN, 0};
+            if (::poll(&p, 1, 200) > 0 && (p.revents & POLLIN)) {
+                int fd = ::accept(listener, nullptr, nullptr);
+                if (fd >= 0) {
+                    auto c = std::make_unique<client_t>();
+                    c->_fd = fd;
+                    c->_thread = std::thread([c = c.get(), &server, &s] {
+                        connection(c->_fd, server, s);
+                        c->_done = true;
+                    });
+                    clients.push_back(std::move(c));
+                }
+            }
+            server.reclaim();
+            for (auto it = clients.begin(); it != clients.end();) {
+                if ((*it)->_done) {
+                    (*it)->_thread.join();
+                    it = clients.erase(it);
+                } else ++it;
+            }
+        }
+        for (auto& c : clients) {
+            if (!c->_done)
+                ::shutdown(c->_fd, SHUT_RDWR);
+            c->_thread.join();
+        }
+
+        std::cerr << "latency (ns) of lookup:\n";
+        server._latency[LOOKUP].print(std::cerr);
+        std::cerr << "latency (ns) of best:\n";
+        server._latency[BEST].print(std::cerr);
+        std::cerr << "requests per batch:\n";
+        server._batches.print(std::cerr);
+        print_stats(std::cerr, server);
+        std::cerr << std::endl;
+    }
+    ::close(listener);
+    ::unlink(s._socket.c_str());
+    return 0;
+}
+
+int main(int argc, char** argv) {
+    settings_t s;
+    bool checkpoint = false, log = false;
+    for (int i = 1; i < argc; ++i) {
+        auto arg = argv[i];
+        const bool has_value = i + 1 < argc;
+        bool ok = true;
+        if (strcmp(arg, "--learner") == 0 && has_value)
+            s._learner = argv[++i];
+        else if (strcmp(arg, "--checkpoint") == 0 && has_value) {
+            s._model = argv[++i];
+            checkpoint = true;
+        } else if (strcmp(arg, "--log") == 0 && has_value) {
+            s._model = argv[++i];
+            log = true;
+        } else if (strcmp(arg, "--live") == 0)
+            s._live = true;
+        else if (strcmp(arg, "--socket") == 0 && has_value)
+            s._socket = argv[++i];
+        else if (strcmp(arg, "--labels") == 0 && has_value)
+            s._labels = std::strtoull(argv[++i], nullptr, 10);
+        else if (strcmp(arg, "--max-clouds") == 0 && has_value)
+            ok = (s._max_clouds = std::strtoull(argv[++i], nullptr, 10)) > 0;
+        else if (strcmp(arg, "--threads") == 0 && has_value)
+            ok = (s._threads = std::strtoull(argv[++i], nullptr, 10)) > 0;
+        else if (strcmp(arg, "--maximize") == 0)
+            s._minimization = false;
+        else if (strcmp(arg, "--discount") == 0 && has_value)
+            s._options._discount = std::strtod(argv[++i], nullptr);
+        else if (strcmp(arg, "--delta") == 0 && has_value)
+            s._delta = std::strtod(argv[++i], nullptr);
+        else if (strcmp(arg, "--split-decay") == 0 && has_value) {
+            s._options._split_decay = std::strtod(argv[++i], nullptr);
+            ok = s._options.valid();
+        } else
+            ok = false;
+        if (!ok) {
+            usage(argv[0]);
+            return strcmp(arg, "--help") == 0 ? 0 : 1;
+        }
+    }
+    const bool m_learner = s._learner == "MLearning" || s._learner == "SimpleMLearning";
+    if (!m_learner && s._learner != "QRefinementTree" && s._learner != "QSimpleRegressor") {
+        std::cerr << "unknown learner " << s._learner << std::endl;
+        return 1;
+    }
+    if (!m_learner && checkpoint) {
+        std::cerr << s._learner << " has no checkpoints" << std::endl;
+        return 1;
+    }
+    if (checkpoint && log) {
+        std::cerr << "either --checkpoint or --log" << std::endl;
+        return 1;
+    }
+    if (s._model.empty() && !s._live) {
+        std::cerr << "nothing to serve; give --checkpoint, --log or --live" << std::endl;
+        return 1;
+    }
+
+    if (s._learner == "QRefinementTree")
+        return serve<QLearning<RefinementTree>>(s);
+    else if (s._learner == "QSimpleRegressor")
+        return serve<QLearning<SimpleRegressor>>(s);
+    else if (s._learner == "MLearning")
+        return serve<MLearning>(s);
+    else
+        return serve<SimpleMLearning>(s);
+}
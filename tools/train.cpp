@@ -0,0 +1,266 @@
+/*
+ * Copyright Peter G. Jensen
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * File:   train.cpp
+ * Author: Peter G. Jensen
+ *
+ * Created on October 17, 2026, 11:50 PM
+ */
+
+#include "transitions.h"
+
+#include "MLearning.h"
+#include "SimpleMLearning.h"
+#include "QLearning.h"
+#include "RefinementTree.h"
+#include "checkpoint.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <limits>
+#include <map>
+#include <thread>
+#include <type_traits>
+
+using namespace prlearn;
+using namespace prlearn::tools;
+
+struct settings_t {
+    std::string _learner = "MLearning";
+    std::string _output, _checkpoint, _resume;
+    size_t _epochs = 1;
+    size_t _threads = std::max(1u, std::thread::hardware_concurrency());
+    bool _minimization = true;
+    double _delta = 1;
+    unsigned _seed = 1;
+    // locations and destinations must be below
+    size_t _max_clouds = 1 << 16;
+    double _sweep = 1e-6;
+    bool _quiet = false;
+    propts_t _options;
+};
+
+static void usage(const char* name) {
+    std::cerr << "usage: " << name << " [options] <log> [<log> ...]\n"
+            << "Trains a learner on recorded transition logs, one transition per line:\n"
+            << "  location;state;label;dest;next-state;next-labels;cost\n"
+            << "with comma-separated states and next-labels (empty for all labels).\n"
+            << "\n"
+            << "  --learner <name>     QRefinementTree, MLearning or SimpleMLearning\n"
+            << "                       (default MLearning)\n"
+            << "  --output <file>      write the strategy as JSON\n"
+            << "  --checkpoint <file>  write the training state, see checkpoint.h\n"
+            << "                       (MLearning and SimpleMLearning)\n"
+            << "  --resume <file>      continue from a checkpoint\n"
+            << "  --epochs <n>         passes over the logs (default 1)\n"
+            << "  --threads <n>        threads for parsing, split-tests and sweeps\n"
+            << "                       (default all cores)\n"
+            << "  --maximize           maximize the value instead of minimizing the cost\n"
+            << "  --discount <d>       discount of the futures (default 0.99)\n"
+            << "  --delta <d>          indifference scale of the split-tests (default 1)\n"
+            << "  --split-decay <w>    MLearning; weight in (0, 1] of the futures from\n"
+            << "                       before a split, 0 keeps them aside (default 0)\n"
+            << "  --seed <n>           seed of the ties broken at random (default 1)\n"
+            << "  --max-clouds <n>     reject transitions of locations (and dests) from n\n"
+            << "                       on (default 65536)\n"
+            << "  --sweep <tolerance>  SimpleMLearning; value-sweep after every epoch\n"
+            << "                       (default 1e-6, 0 for none)\n"
+            << "  --quiet              no progress on stderr\n";
+}
+
+template<typename Learner>
+static bool write_strategy(const std::string& path, const settings_t& s, const transitions_t& log,
+        const std::vector<Learner>& clouds) {
+    std::ofstream out(path);
+    // labels are written as they are in the logs
+    std::map<size_t, size_t> labels;
+    for (auto l : log._label) labels[l] = l;
+    for (auto l : log._next) labels[l] = l;
+    out << "{\"learner\":\"" << s._learner << "\",\"dimen\":" << log._dimen
+            << ",\"minimization\":" << (s._minimization ? "true" : "false") << ",\"clouds\":{";
+    bool first = true;
+    for (size_t c = 0; c < clouds.size(); ++c) {
+        if (clouds[c].size() == 0) continue;
+        out << (first ? "\n" : ",\n") << "\t\"" << c << "\":\n";
+        clouds[c].print(out, 1, labels, clouds);
+        first = false;
+    }
+    out << "\n}}\n";
+    return (bool) out;
+}
+
+template<typename Learner>
+static int train(const transitions_t& log, const settings_t& s) {
+    constexpr bool checkpoints = !std::is_same<Learner, QLearning<RefinementTree>>::value;
+    std::vector<Learner> clouds;
+    if constexpr (checkpoints) {
+        if (!s._resume.empty()) {
+            std::ifstream in(s._resume, std::ios::binary);
+            if (!read_checkpoint(in, clouds)) {
+                std::cerr << "could not resume from " << s._resume << std::endl;
+                return 1;
+            }
+        }
+    }
+    if constexpr (std::is_same<Learner, MLearning>::value) {
+        // the clouds only know the dimension they were trained on
+        for (auto& c : clouds) {
+            if (log.size() > 0 && c.dimen() != 0 && c.dimen() != log._dimen) {
+                std::cerr << s._resume << ": dimension " << c.dimen() << " differs from " << log._dimen
+                        << " of the logs" << std::endl;
+                return 1;
+            }
+        }
+    }
+    if (clouds.size() < log.clouds())
+        clouds.resize(log.clouds());
+
+    propts_t options = s._options;
+    options._threads = s._threads;
+    std::srand(s._seed);
+    for (size_t epoch = 0; epoch < s._epochs; ++epoch) {
+        auto start = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < log.size(); ++i) {
+            // the next-labels are passed as given; none means all labels
+            const auto n_next = log.n_next(i);
+            clouds[log._location[i]].addSample(log._dimen, log.from(i), log.to(i),
+                    n_next > 0 ? const_cast<size_t*> (log.next(i)) : nullptr, n_next,
+                    log._label[i], log._dest[i], log._cost[i], clouds,
+                    s._minimization, s._delta, options);
+        }
+        if constexpr (std::is_same<Learner, SimpleMLearning>::value) {
+            if (s._sweep > 0)
+                SimpleMLearning::sweep(clouds, s._minimization, s._sweep,
+                    std::numeric_limits<double>::infinity(), s._threads);
+        }
+        const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        if (!s._quiet) {
+            size_t nodes = 0;
+            for (auto& c : clouds) nodes += c.size();
+            std::cerr << "epoch " << (epoch + 1) << "/" << s._epochs << ": " << log.size() << " transitions in "
+                    << seconds << " s (" << (seconds > 0 ? log.size() / seconds : 0) << "/s), "
+                    << nodes << " nodes" << std::endl;
+        }
+    }
+
+    if (!s._output.empty() && !write_strategy(s._output, s, log, clouds)) {
+        std::cerr << "could not write " << s._output << std::endl;
+        return 1;
+    }
+    if constexpr (checkpoints) {
+        if (!s._checkpoint.empty()) {
+            std::ofstream out(s._checkpoint, std::ios::binary | std::ios::trunc);
+            write_checkpoint(out, clouds);
+            if (!out.flush()) {
+                std::cerr << "could not write " << s._checkpoint << std::endl;
+                return 1;
+            }
+        }
+    }
+    return 0;
+}
+
+int main(int argc, char** argv) {
+    settings_t s;
+    std::vector<std::string> logs;
+    for (int i = 1; i < argc; ++i) {
+        auto arg = argv[i];
+        const bool has_value = i + 1 < argc;
+        bool ok = true;
+        if (strcmp(arg, "--learner") == 0 && has_value)
+            s._learner = argv[++i];
+        else if (strcmp(arg, "--output") == 0 && has_value)
+            s._output = argv[++i];
+        else if (strcmp(arg, "--checkpoint") == 0 && has_value)
+            s._checkpoint = argv[++i];
+        else if (strcmp(arg, "--resume") == 0 && has_value)
+            s._resume = argv[++i];
+        else if (strcmp(arg, "--epochs") == 0 && has_value)
+            s._epochs = std::strtoull(argv[++i], nullptr, 10);
+        else if (strcmp(arg, "--threads") == 0 && has_value)
+            ok = (s._threads = std::strtoull(argv[++i], nullptr, 10)) > 0;
+        else if (strcmp(arg, "--maximize") == 0)
+            s._minimization = false;
+        else if (strcmp(arg, "--discount") == 0 && has_value)
+            s._options._discount = std::strtod(argv[++i], nullptr);
+        else if (strcmp(arg, "--delta") == 0 && has_value)
+            s._delta = std::strtod(argv[++i], nullptr);
+        else if (strcmp(arg, "--split-decay") == 0 && has_value) {
+            s._options._split_decay = std::strtod(argv[++i], nullptr);
+            ok = s._options.valid();
+        } else if (strcmp(arg, "--seed") == 0 && has_value)
+            s._seed = std::strtoul(argv[++i], nullptr, 10);
+        else if (strcmp(arg, "--max-clouds") == 0 && has_value)
+            ok = (s._max_clouds = std::strtoull(argv[++i], nullptr, 10)) > 0;
+        else if (strcmp(arg, "--sweep") == 0 && has_value)
+            s._sweep = std::strtod(argv[++i], nullptr);
+        else if (strcmp(arg, "--quiet") == 0)
+            s._quiet = true;
+        else if (arg[0] != '-')
+            logs.emplace_back(arg);
+        else
+            ok = false;
+        if (!ok) {
+            usage(argv[0]);
+            return strcmp(arg, "--help") == 0 ? 0 : 1;
+        }
+    }
+    if (logs.empty()) {
+        usage(argv[0]);
+        return 1;
+    }
+    if (s._learner != "QRefinementTree" && s._learner != "MLearning" && s._learner != "SimpleMLearning") {
+        std::cerr << "unknown learner " << s._learner << std::endl;
+        return 1;
+    }
+    if (s._learner == "QRefinementTree" && (!s._checkpoint.empty() || !s._resume.empty())) {
+        std::cerr << "QRefinementTree has no checkpoints" << std::endl;
+        return 1;
+    }
+
+    transitions_t log;
+    auto start = std::chrono::steady_clock::now();
+    for (auto& path : logs) {
+        transitions_t part;
+        std::string error;
+        if (!read_transitions(path, s._threads, s._max_clouds, part, error)) {
+            std::cerr << error << std::endl;
+            return 1;
+        }
+        if (log.size() > 0 && part.size() > 0 && part._dimen != log._dimen) {
+            std::cerr << path << ": dimension " << part._dimen << " differs from " << log._dimen << std::endl;
+            return 1;
+        }
+        log.append(part);
+    }
+    if (!s._quiet) {
+        std::cerr << "read " << log.size() << " transitions of dimension " << log._dimen << " in "
+                << std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() << " s" << std::endl;
+    }
+
+    if (s._learner == "QRefinementTree")
+        return train<QLearning<RefinementTree>>(log, s);
+    else if (s._learner == "MLearning")
+        return train<MLearning>(log, s);
+    else
+        return train<SimpleMLearning>(log, s);
+}
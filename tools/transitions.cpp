@@ -0,0 +1,224 @@
+/*
+ * Copyright Peter G. Jensen
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * File:   transitions.cpp
+ * Author: Peter G. Jensen
+ *
+ * Created on October 17, 2026, 11:50 PM
+ */
+
+#include "transitions.h"
+#include "threadpool.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+
+namespace prlearn {
+    namespace tools {
+
+        size_t transitions_t::clouds() const {
+            size_t n = 0;
+            for (size_t i = 0; i < size(); ++i)
+                n = std::max(n, std::max(_location[i], _dest[i]) + 1);
+            return n;
+        }
+
+        void transitions_t::append(const transitions_t& other) {
+            if (size() == 0)
+                _dimen = other._dimen;
+            _location.insert(_location.end(), other._location.begin(), other._location.end());
+            _label.insert(_label.end(), other._label.begin(), other._label.end());
+            _dest.insert(_dest.end(), other._dest.begin(), other._dest.end());
+            _cost.insert(_cost.end(), other._cost.begin(), other._cost.end());
+            _from.insert(_from.end(), other._from.begin(), other._from.end());
+            _to.insert(_to.end(), other._to.begin(), other._to.end());
+            const auto base = _next.size();
+            for (size_t i = 1; i < other._next_offset.size(); ++i)
+                _next_offset.push_back(base + other._next_offset[i]);
+            _next.insert(_next.end(), other._next.begin(), other._next.end());
+        }
+
+        namespace {
+
+            // a line being parsed; the numbers may not run past _end
+            struct line_t {
+                const char* _pos;
+                const char* _end;
+
+                bool number(double& value) {
+                    char* end;
+                    if (_pos >= _end) return false;
+                    value = std::strtod(_pos, &end);
+                    if (end == _pos || end > _end) return false;
+                    _pos = end;
+                    return true;
+                }
+
+                bool number(size_t& value) {
+                    char* end;
+                    while (_pos < _end && (*_pos == ' ' || *_pos == '\t')) ++_pos;
+                    if (_pos >= _end || !std::isdigit((unsigned char) *_pos)) return false;
+                    value = std::strtoull(_pos, &end, 10);
+                    if (end > _end) return false;
+                    _pos = end;
+                    return true;
+                }
+
+                bool expect(char c) {
+                    while (_pos < _end && (*_pos == ' ' || *_pos == '\t')) ++_pos;
+                    if (_pos >= _end || *_pos != c) return false;
+                    ++_pos;
+                    return true;
+                }
+
+                bool at_field_end() {
+                    while (_pos < _end && (*_pos == ' ' || *_pos == '\t')) ++_pos;
+                    return _pos == _end || *_pos == ';';
+                }
+
+                // comma-separated, possibly empty, up to the next ; or the end
+                template<typename T>
+                bool list(std::vector<T>& values) {
+                    if (at_field_end()) return true;
+                    do {
+                        T v;
+                        if (!number(v)) return false;
+                        values.push_back(v);
+                    } while (expect(','));
+                    return at_field_end();
+                }
+            };
+
+            struct chunk_t {
+                const char* _begin;
+                const char* _end;
+                size_t _first_line;
+                size_t _max_clouds;
+                transitions_t _result;
+                std::string _error;
+            };
+
+            void parse(chunk_t& chunk) {
+                auto& r = chunk._result;
+                size_t line_no = chunk._first_line;
+                std::vector<double> from, to;
+                for (auto p = chunk._begin; p < chunk._end; ++line_no) {
+                    auto nl = static_cast<const char*> (memchr(p, '\n', chunk._end - p));
+                    auto end = nl == nullptr ? chunk._end : nl;
+                    auto next = nl == nullptr ? chunk._end : nl + 1;
+                    if (end > p && end[-1] == '\r') --end;
+                    line_t line{p, end};
+                    p = next;
+                    while (line._pos < end && std::isspace((unsigned char) *line._pos)) ++line._pos;
+                    if (line._pos == end || *line._pos == '#')
+                        continue;
+                    size_t location, label, dest;
+                    double cost;
+                    from.clear();
+                    to.clear();
+                    const auto n_next = r._next.size();
+                    bool ok = line.number(location) && line.expect(';') &&
+                            line.list(from) && line.expect(';') &&
+                            line.number(label) && line.expect(';') &&
+                            line.number(dest) && line.expect(';') &&
+                            line.list(to) && line.expect(';') &&
+                            line.list(r._next) && line.expect(';') &&
+                            line.number(cost) && line.at_field_end() && line._pos == end;
+                    if (ok && (location >= chunk._max_clouds || dest >= chunk._max_clouds)) {
+                        chunk._error = "location or dest beyond the " + std::to_string(chunk._max_clouds) + " clouds allowed";
+                    } else if (ok && from.size() != to.size()) {
+                        chunk._error = "state and next-state differ in dimension";
+                    } else if (ok && r.size() > 0 && from.size() != r._dimen) {
+                        chunk._error = "dimension differs from the lines before";
+                    } else if (!ok) {
+                        chunk._error = "expected location;state;label;dest;next-state;next-labels;cost";
+                    }
+                    if (!chunk._error.empty()) {
+                        chunk._error = "line " + std::to_string(line_no) + ": " + chunk._error;
+                        return;
+                    }
+                    r._dimen = from.size();
+                    r._location.push_back(location);
+                    r._label.push_back(label);
+                    r._dest.push_back(dest);
+                    r._cost.push_back(cost);
+                    r._from.insert(r._from.end(), from.begin(), from.end());
+                    r._to.insert(r._to.end(), to.begin(), to.end());
+                    // the learners expect the next-labels sorted
+                    std::sort(r._next.begin() + n_next, r._next.end());
+                    r._next_offset.push_back(r._next.size());
+                }
+            }
+        }
+
+        bool read_transitions(const std::string& path, size_t threads, size_t max_clouds,
+                transitions_t& result, std::string& error) {
+            std::ifstream in(path, std::ios::binary);
+            if (!in) {
+                error = "could not open " + path;
+                return false;
+            }
+            std::stringstream buffer;
+            buffer << in.rdbuf();
+            const std::string data = buffer.str();
+
+            // chunks end after a newline, so every line is in a single chunk
+            threads = std::max<size_t>(1, threads);
+            const size_t n_chunks = data.size() < (1 << 20) ? 1 : threads * 4;
+            std::vector<chunk_t> chunks;
+            const char* begin = data.data();
+            const char* end = data.data() + data.size();
+            size_t line = 1;
+            for (size_t c = 0; c < n_chunks && begin < end; ++c) {
+                auto stop = c + 1 == n_chunks ? end : std::min(end, data.data() + ((c + 1) * data.size()) / n_chunks);
+                if (stop < end) {
+                    auto nl = static_cast<const char*> (memchr(stop, '\n', end - stop));
+                    stop = nl == nullptr ? end : nl + 1;
+                }
+                if (stop <= begin) continue;
+                chunks.push_back(chunk_t{begin, stop, line, max_clouds, transitions_t(), std::string()});
+                line += std::count(begin, stop, '\n');
+                begin = stop;
+            }
+
+            threadpool_t::shared(threads).run(chunks.size(), [&chunks](size_t c) {
+                parse(chunks[c]);
+            });
+
+            transitions_t res;
+            for (auto& c : chunks) {
+                if (!c._error.empty()) {
+                    error = path + ": " + c._error;
+                    return false;
+                }
+                if (res.size() > 0 && c._result.size() > 0 && c._result._dimen != res._dimen) {
+                    error = path + ": line " + std::to_string(c._first_line) + " onwards: dimension differs from the lines before";
+                    return false;
+                }
+                if (c._result.size() > 0)
+                    res.append(c._result);
+            }
+            result = std::move(res);
+            return true;
+        }
+    }
+}
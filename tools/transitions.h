@@ -0,0 +1,88 @@
+/*
+ * Copyright Peter G. Jensen
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * File:   transitions.h
+ * Author: Peter G. Jensen
+ *
+ * Created on October 17, 2026, 11:50 PM
+ */
+
+#ifndef TOOLS_TRANSITIONS_H
+#define TOOLS_TRANSITIONS_H
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+namespace prlearn {
+    namespace tools {
+
+        // A recorded transition log, as text; one transition per line
+        //
+        //   location;state;label;dest;next-state;next-labels;cost
+        //
+        // where state and next-state are comma-separated doubles (all of the
+        // same dimension), next-labels the comma-separated labels enabled in
+        // dest (empty for all labels) and the rest single numbers. Location
+        // 0 is the sink, as for the learners. Empty lines and lines starting
+        // with # are skipped.
+        struct transitions_t {
+            size_t _dimen = 0;
+            std::vector<size_t> _location, _label, _dest;
+            std::vector<double> _cost;
+            // _dimen values per transition
+            std::vector<double> _from, _to;
+            // the next-labels of transition i are _next[_next_offset[i]] up
+            // to _next[_next_offset[i + 1]], sorted.
+            std::vector<size_t> _next_offset{0};
+            std::vector<size_t> _next;
+
+            size_t size() const {
+                return _location.size();
+            }
+
+            const double* from(size_t i) const {
+                return _from.data() + i * _dimen;
+            }
+
+            const double* to(size_t i) const {
+                return _to.data() + i * _dimen;
+            }
+
+            const size_t* next(size_t i) const {
+                return _next.data() + _next_offset[i];
+            }
+
+            size_t n_next(size_t i) const {
+                return _next_offset[i + 1] - _next_offset[i];
+            }
+
+            // one more than the largest location or destination
+            size_t clouds() const;
+            void append(const transitions_t& other);
+        };
+
+        // parses the file in chunks on up to threads threads; locations and
+        // destinations must be below max_clouds. On failure the error names
+        // the offending line.
+        bool read_transitions(const std::string& path, size_t threads, size_t max_clouds,
+                transitions_t& result, std::string& error);
+    }
+}
+
+#endif /* TOOLS_TRANSITIONS_H */